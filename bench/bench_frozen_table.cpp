@@ -0,0 +1,89 @@
+#include <micro_router/frozen_table.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Image size and lookup latency of FrozenTable on generated multi-tenant
+// route sets of 1M+ routes, for two route shapes.
+
+namespace
+{
+  struct Rng
+  {
+    std::uint64_t s = 0x2545F4914F6CDD1Dull;
+    std::uint64_t next()
+    {
+      s ^= s << 13;
+      s ^= s >> 7;
+      s ^= s << 17;
+      return s;
+    }
+  };
+
+  struct Shape
+  {
+    const char *name;
+    std::vector<std::string> tails; // appended to "/tenants/t<n>"
+    std::vector<std::string> probes; // request tails, same order
+  };
+
+  void run(const Shape &shape, std::size_t tenants)
+  {
+    using namespace micro_router;
+
+    Router router;
+    for (std::size_t t = 0; t < tenants; ++t)
+    {
+      for (const auto &tail : shape.tails)
+        router.get("/tenants/t" + std::to_string(t) + tail, nullptr);
+    }
+
+    const std::vector<unsigned char> image = freeze(router);
+    FrozenTable table(image.data(), image.size());
+
+    std::vector<std::string> paths;
+    Rng rng;
+    for (std::size_t i = 0; i < 4096; ++i)
+    {
+      const std::size_t t = static_cast<std::size_t>(rng.next() % tenants);
+      const std::size_t k = static_cast<std::size_t>(rng.next() % shape.probes.size());
+      paths.push_back("/tenants/t" + std::to_string(t) + shape.probes[k]);
+    }
+
+    const std::size_t iterations = 1000000;
+    std::size_t sink = 0;
+    for (std::size_t i = 0; i < 10000; ++i) // warm up caches and scratch buffers
+      sink += table.find(Method::Get, paths[i % paths.size()]);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; ++i)
+      sink += table.find(Method::Get, paths[i % paths.size()]);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) /
+                      static_cast<double>(iterations);
+    std::cout << shape.name << ": " << router.size() << " routes, "
+              << static_cast<double>(image.size()) / static_cast<double>(router.size()) << " bytes/route, " << ns
+              << " ns/find (sink " << sink % 10 << ")\n";
+  }
+} // namespace
+
+int main()
+{
+  const Shape crud{"crud",
+                   {"/orders", "/orders/:id", "/invoices/:id", "/users/:id/settings"},
+                   {"/orders", "/orders/42", "/invoices/7", "/users/3/settings"}};
+  const Shape versioned{"versioned",
+                        {"/api/v1/orders", "/api/v1/orders/:id", "/api/v2/orders/:id/items/{item}",
+                         "/api/v2/invoices/:id/pdf", "/api/v2/users/:id/settings/notifications"},
+                        {"/api/v1/orders", "/api/v1/orders/9", "/api/v2/orders/9/items/x", "/api/v2/invoices/1/pdf",
+                         "/api/v2/users/5/settings/notifications"}};
+
+  run(crud, 300000);      // 1.2M routes
+  run(versioned, 300000); // 1.5M routes
+  return 0;
+}
@@ -0,0 +1,113 @@
+#include <micro_router/micro_router.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Per-connection last-route hints on keep-alive traces: each connection
+// mostly repeats one route (polling, pagination) with changing params and
+// occasionally hits another one.
+
+namespace
+{
+  struct Rng
+  {
+    std::uint64_t s = 0x2545F4914F6CDD1Dull;
+    std::uint64_t next()
+    {
+      s ^= s << 13;
+      s ^= s >> 7;
+      s ^= s << 17;
+      return s;
+    }
+  };
+
+  const char *resources[] = {"users", "orders", "invoices", "products", "carts", "reviews", "tickets", "teams",
+                             "projects", "files", "events", "payments", "shipments", "coupons", "reports", "alerts"};
+
+  std::string path_for(std::size_t route, std::uint64_t n)
+  {
+    const std::string res = resources[route / 6 % 16];
+    const std::string ver = "/api/v" + std::to_string(route / 96 + 1) + "/";
+    switch (route % 6)
+    {
+    case 0:
+      return ver + res;
+    case 1:
+      return ver + res + "/" + std::to_string(n);
+    case 2:
+      return ver + res + "/" + std::to_string(n) + "/history";
+    case 3:
+      return ver + res + "/" + std::to_string(n) + "/comments";
+    case 4:
+      return ver + res + "/" + std::to_string(n) + "/comments/" + std::to_string(n % 97);
+    default:
+      return ver + res + "/search";
+    }
+  }
+} // namespace
+
+int main()
+{
+  using namespace micro_router;
+
+  const std::size_t route_count = 288; // 3 versions x 16 resources x 6 routes
+  const char *shapes[] = {"", "/:id", "/:id/history", "/:id/comments", "/:id/comments/:cid", "/search"};
+
+  Router router;
+  for (std::size_t r = 0; r < route_count; ++r)
+  {
+    const std::string base = "/api/v" + std::to_string(r / 96 + 1) + "/" + resources[r / 6 % 16];
+    router.get(base + shapes[r % 6], [](const Request &, Response &) {});
+  }
+  router.prepare_hints();
+
+  // Trace: 256 connections x 64 requests, 90% on the connection's route.
+  Rng rng;
+  std::vector<std::string> trace;
+  for (std::size_t c = 0; c < 256; ++c)
+  {
+    std::size_t favorite = rng.next() % route_count;
+    if (favorite % 6 == 5)
+      favorite -= 4; // "/search" is shadowed by "/:id": keep the common case realistic
+    for (std::size_t i = 0; i < 64; ++i)
+    {
+      const bool same = rng.next() % 10 != 0;
+      trace.push_back(path_for(same ? favorite : rng.next() % route_count, 1000 + i));
+    }
+  }
+
+  const int rounds = 50;
+  ParamViews params;
+  std::size_t sink = 0;
+
+  auto run = [&](bool hinted)
+  {
+    const auto t0 = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round)
+    {
+      for (std::size_t c = 0; c < 256; ++c)
+      {
+        RouteHint hint; // one per connection
+        for (std::size_t i = 0; i < 64; ++i)
+        {
+          const std::string &p = trace[c * 64 + i];
+          sink += hinted ? router.resolve(Method::Get, p, params, hint) : router.resolve(Method::Get, p, params);
+        }
+      }
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / (rounds * trace.size());
+  };
+
+  run(false); // warm up
+  const double plain_ns = run(false);
+  const double hinted_ns = run(true);
+
+  std::cout << route_count << " routes, " << trace.size() << " requests/round: resolve " << plain_ns
+            << " ns, hinted " << hinted_ns << " ns (sink " << sink << ")\n";
+  return 0;
+}
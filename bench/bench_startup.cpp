@@ -0,0 +1,63 @@
+#include <micro_router/micro_router.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Startup cost of registering N generated routes: one add() per route vs
+// a single add_all() batch.
+
+static std::vector<micro_router::RouteSpec> make_specs(std::size_t n)
+{
+  using namespace micro_router;
+
+  const char *tails[] = {"/orders", "/orders/:id", "/invoices/{id}", "/users/:id/settings"};
+
+  std::vector<RouteSpec> specs;
+  specs.reserve(n);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    RouteSpec s;
+    s.method = Method::Get;
+    s.pattern = "/tenants/t" + std::to_string(i / 4) + tails[i % 4];
+    s.handler = [](const Request &, Response &) {};
+    specs.push_back(std::move(s));
+  }
+  return specs;
+}
+
+template <class F>
+static double time_ms(F &&f)
+{
+  const auto t0 = std::chrono::steady_clock::now();
+  f();
+  const auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+int main()
+{
+  using namespace micro_router;
+
+  for (std::size_t n : {10000u, 100000u, 1000000u})
+  {
+    auto specs_a = make_specs(n);
+    auto specs_b = make_specs(n);
+
+    Router one_by_one;
+    const double add_ms = time_ms([&]
+                                  {
+      for (auto &s : specs_a)
+        one_by_one.add(s.method, s.pattern, std::move(s.handler)); });
+
+    Router bulk;
+    const double bulk_ms = time_ms([&]
+                                   { bulk.add_all(std::move(specs_b)); });
+
+    std::cout << n << " routes: add " << add_ms << " ms, add_all " << bulk_ms << " ms\n";
+  }
+
+  return 0;
+}
@@ -0,0 +1,70 @@
+#include <micro_router/work_stealing.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Throughput of WorkStealingDispatcher from 1 to N workers. Traffic is
+// skewed (half of it on one route), so affinity placement alone would
+// pile work on one worker; stealing spreads it.
+
+int main()
+{
+  using namespace micro_router;
+
+  Router router;
+  for (int r = 0; r < 32; ++r)
+  {
+    router.get("/r" + std::to_string(r) + "/:id", [](const Request &req, Response &res)
+               {
+                 // ~2 us of handler work
+                 double x = static_cast<double>(req.params.at("id").size());
+                 for (int i = 0; i < 400; ++i)
+                   x = std::sqrt(x + i);
+                 res.status = x > 0 ? 200 : 500; });
+  }
+
+  std::vector<std::string> paths;
+  std::uint64_t rng = 0x2545F4914F6CDD1Dull;
+  for (int i = 0; i < 200000; ++i)
+  {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    const std::uint64_t route = (rng & 1) ? 0 : rng % 32;
+    paths.push_back("/r" + std::to_string(route) + "/" + std::to_string(i));
+  }
+
+  const std::size_t max_workers = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+  std::vector<std::size_t> counts;
+  for (std::size_t n = 1; n < max_workers; n *= 2)
+    counts.push_back(n);
+  counts.push_back(max_workers);
+
+  for (const std::size_t n : counts)
+  {
+    WorkStealingDispatcher pool(router, n);
+
+    const auto t0 = std::chrono::steady_clock::now();
+    for (const auto &p : paths)
+    {
+      Request req;
+      req.method = Method::Get;
+      req.path = p;
+      pool.submit(std::move(req));
+    }
+    pool.wait_idle();
+    const auto t1 = std::chrono::steady_clock::now();
+
+    const double s = std::chrono::duration<double>(t1 - t0).count();
+    std::cout << n << " workers: " << static_cast<std::uint64_t>(paths.size() / s) << " req/s, "
+              << pool.steals() << " steals\n";
+  }
+
+  return 0;
+}
@@ -0,0 +1,46 @@
+#include <micro_router/micro_router.hpp>
+#include <iostream>
+
+int main()
+{
+  using namespace micro_router;
+
+  Router router;
+
+  RouteOptions upload;
+  upload.max_body_bytes = 1024;
+
+  router.post("/upload", [](const Request &req, Response &res)
+              {
+    std::size_t total = 0;
+    for (std::string_view chunk = req.body->next(); !chunk.empty(); chunk = req.body->next())
+      total += chunk.size(); // process each chunk as it arrives
+
+    if (req.body->too_large())
+    {
+      res.status = 413;
+      return;
+    }
+    res.body = "Received " + std::to_string(total) + " bytes"; },
+              upload);
+
+  // Stand-in for a socket: the server hands out one receive buffer at a
+  // time and only reads the next one once the handler released the last.
+  const char *packets[] = {"first part, ", "second part, ", "last part"};
+  std::size_t next = 0;
+
+  BodySource body(
+      [&]() -> std::string_view
+      { return next < 3 ? std::string_view(packets[next++]) : std::string_view{}; },
+      [](std::size_t n)
+      { std::cout << "released " << n << " bytes, re-arming read\n"; });
+
+  Request req{Method::Post, "/upload"};
+  req.body = &body;
+  Response res;
+
+  router.dispatch(req, res);
+
+  std::cout << res.body << "\n";
+  return 0;
+}
@@ -0,0 +1,439 @@
+#pragma once
+
+/**
+ * @file dispatch_queue.hpp
+ * @brief Priority / deadline aware queue of matched requests (header-only).
+ *
+ * DispatchQueue sits between a server's accept loop and its workers:
+ * - push() matches the request once and stores (route id, request)
+ * - pop() hands back the next request to run, by scheduling policy
+ * - run() calls the route handler through Router::invoke
+ *
+ * Policies:
+ * - StrictPriority:   highest RouteOptions::priority first, FIFO inside a
+ *                     class; a request that waited longer than
+ *                     `starvation_limit` is served first regardless.
+ * - EarliestDeadline: smallest (enqueue time + RouteOptions::deadline)
+ *                     first; routes without a deadline use `default_deadline`.
+ *
+ * Admission:
+ * - Admission::CoDel sheds requests at the head when their queue delay
+ *   (enqueue -> pop) stayed above `codel_target` for a whole
+ *   `codel_interval`, dropping faster while the standing queue persists
+ *   (controlled delay, RFC 8289). Shed requests are still returned by
+ *   pop() with `shed = true`; run() answers them 503 without calling the
+ *   handler. RouteOptions::codel_target overrides the target per route;
+ *   each distinct target keeps its own controller state, so a lenient
+ *   route never clears the standing-queue timer of strict ones.
+ *
+ * Threading:
+ * - push, pop and run may be called from any number of threads.
+ * - StrictPriority: each priority class has its own lock, so producers
+ *   of different classes never contend. A bitmap of non-empty classes and
+ *   each head's enqueue time are atomics, so pop picks a class without
+ *   locking the others and then locks only that one.
+ * - EarliestDeadline keeps one heap behind one lock; CoDel state has its
+ *   own lock, taken only by pop.
+ *
+ * Notes:
+ * - pop() does not block; an empty queue returns std::nullopt.
+ * - The Router must outlive the queue and must not change while requests
+ *   are queued (route ids are indices into it).
+ */
+
+#include <micro_router/micro_router.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace micro_router
+{
+  /**
+   * @brief A matched request waiting in a DispatchQueue.
+   */
+  struct QueuedRequest
+  {
+    Request req;
+    std::size_t route_id = Router::npos;
+    std::uint8_t priority = 0;
+    std::chrono::microseconds codel_target{0};
+    std::chrono::steady_clock::time_point enqueued_at{};
+    std::chrono::steady_clock::time_point deadline{};
+    bool shed = false; // dropped by admission control, answer 503
+  };
+
+  /**
+   * @brief Scheduling policy of a DispatchQueue.
+   */
+  enum class SchedulePolicy : std::uint8_t
+  {
+    StrictPriority = 0,
+    EarliestDeadline
+  };
+
+  /**
+   * @brief Admission control mode of a DispatchQueue.
+   */
+  enum class Admission : std::uint8_t
+  {
+    None = 0,
+    CoDel
+  };
+
+  /**
+   * @brief Queue of matched requests scheduled by priority or deadline.
+   *
+   * Typical usage:
+   * @code
+   * micro_router::DispatchQueue q(router);
+   * q.push(std::move(req));                // accept thread
+   *
+   * if (auto job = q.pop()) {               // worker thread
+   *   micro_router::Response res;
+   *   q.run(*job, res);
+   * }
+   * @endcode
+   */
+  class DispatchQueue final
+  {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Config
+    {
+      SchedulePolicy policy = SchedulePolicy::StrictPriority;
+
+      /// StrictPriority: max wait before a low class overtakes higher ones.
+      std::chrono::microseconds starvation_limit{std::chrono::milliseconds(100)};
+
+      /// EarliestDeadline: budget for routes registered without a deadline.
+      std::chrono::microseconds default_deadline{std::chrono::seconds(1)};
+
+      Admission admission = Admission::None;
+
+      /// CoDel: acceptable standing queue delay.
+      std::chrono::microseconds codel_target{std::chrono::milliseconds(5)};
+
+      /// CoDel: how long the delay must stay above target before shedding.
+      std::chrono::microseconds codel_interval{std::chrono::milliseconds(100)};
+    };
+
+    explicit DispatchQueue(const Router &router) : router_(&router) {}
+    DispatchQueue(const Router &router, Config cfg) : router_(&router), cfg_(cfg) {}
+
+    DispatchQueue(const DispatchQueue &) = delete;
+    DispatchQueue &operator=(const DispatchQueue &) = delete;
+
+    ~DispatchQueue()
+    {
+      for (auto &l : levels_)
+        delete l.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Match `req` and enqueue it.
+     * @return false if no route matches (the request is not queued).
+     */
+    bool push(Request req, Clock::time_point now = Clock::now())
+    {
+      // Id-only lookup: fills params / route, no handler copy.
+      const std::size_t id = router_->route(req);
+      if (id == Router::npos)
+        return false;
+
+      const RouteOptions &opts = router_->route_options(id);
+
+      QueuedRequest q;
+      q.req = std::move(req);
+      q.route_id = id;
+      q.priority = opts.priority;
+      q.codel_target = opts.codel_target.count() > 0 ? opts.codel_target : cfg_.codel_target;
+      q.enqueued_at = now;
+      q.deadline = now + (opts.deadline.count() > 0 ? opts.deadline : cfg_.default_deadline);
+
+      // Counted first, so size() never dips below the items a pop can see.
+      size_.fetch_add(1, std::memory_order_release);
+
+      if (cfg_.policy == SchedulePolicy::EarliestDeadline)
+      {
+        std::lock_guard<std::mutex> lock(edf_mutex_);
+        edf_.push_back(Entry{seq_++, std::move(q)});
+        std::push_heap(edf_.begin(), edf_.end(), EntryLater{});
+      }
+      else
+      {
+        const std::size_t p = q.priority;
+        Level &l = level_(p);
+        std::lock_guard<std::mutex> lock(l.mutex);
+        if (l.items.empty())
+        {
+          l.head.store(q.enqueued_at.time_since_epoch().count(), std::memory_order_relaxed);
+          nonempty_[p / 64].fetch_or(std::uint64_t{1} << (p % 64), std::memory_order_release);
+        }
+        l.items.push_back(std::move(q));
+      }
+      return true;
+    }
+
+    /**
+     * @brief Remove and return the next request to run, if any.
+     */
+    std::optional<QueuedRequest> pop(Clock::time_point now = Clock::now())
+    {
+      if (size_.load(std::memory_order_acquire) == 0)
+        return std::nullopt;
+
+      std::optional<QueuedRequest> q = cfg_.policy == SchedulePolicy::EarliestDeadline ? pop_edf_() : pop_level_(now);
+      if (!q)
+        return std::nullopt;
+      size_.fetch_sub(1, std::memory_order_acq_rel);
+
+      if (cfg_.admission == Admission::CoDel)
+      {
+        std::lock_guard<std::mutex> lock(codel_mutex_);
+        q->shed = codel_should_drop_(*q, now);
+      }
+      return q;
+    }
+
+    /**
+     * @brief Run a popped request's handler.
+     *
+     * Shed requests get `res.status = 503` and the handler is not called.
+     * @return true if the handler ran.
+     */
+    bool run(const QueuedRequest &q, Response &res) const
+    {
+      if (q.shed)
+      {
+        res.status = 503;
+        return false;
+      }
+      return router_->invoke(q.route_id, q.req, res);
+    }
+
+    /// Snapshot; other threads may push or pop concurrently.
+    std::size_t size() const noexcept { return size_.load(std::memory_order_acquire); }
+    bool empty() const noexcept { return size() == 0; }
+
+  private:
+    struct Entry
+    {
+      std::uint64_t seq = 0; // FIFO tie-break for equal deadlines
+      QueuedRequest item;
+    };
+
+    struct EntryLater
+    {
+      bool operator()(const Entry &a, const Entry &b) const
+      {
+        if (a.item.deadline != b.item.deadline)
+          return a.item.deadline > b.item.deadline;
+        return a.seq > b.seq;
+      }
+    };
+
+    static constexpr std::size_t levels = 256; // one per RouteOptions::priority value
+
+    /// One priority class: FIFO behind its own lock.
+    struct Level
+    {
+      std::mutex mutex;
+      std::deque<QueuedRequest> items;
+      std::atomic<Clock::rep> head{0}; // enqueued_at of items.front(), while non-empty
+    };
+
+    /// Class `p`, created on first use (lock-free install).
+    Level &level_(std::size_t p)
+    {
+      Level *l = levels_[p].load(std::memory_order_acquire);
+      if (l != nullptr)
+        return *l;
+
+      auto fresh = std::make_unique<Level>();
+      if (levels_[p].compare_exchange_strong(l, fresh.get(), std::memory_order_acq_rel))
+        return *fresh.release();
+      return *l; // another thread installed it first
+    }
+
+    /// Highest non-empty class, unless a lower class head is starving.
+    /// Reads only atomics; the choice is re-checked under the class lock.
+    std::size_t next_level_(Clock::time_point now) const
+    {
+      std::size_t best = levels;
+      Clock::rep best_head = 0;
+      for (std::size_t w = nonempty_.size(); w-- > 0;)
+      {
+        for (std::uint64_t bits = nonempty_[w].load(std::memory_order_acquire); bits != 0;)
+        {
+          const std::size_t bit = 63 - static_cast<std::size_t>(count_leading_zeros_(bits));
+          bits &= ~(std::uint64_t{1} << bit);
+
+          const Level *l = levels_[w * 64 + bit].load(std::memory_order_acquire);
+          const Clock::rep head = l->head.load(std::memory_order_relaxed);
+          if (best == levels)
+          {
+            best = w * 64 + bit;
+            best_head = head;
+          }
+          else if (now - Clock::time_point(Clock::duration(head)) > cfg_.starvation_limit && head < best_head)
+          {
+            best = w * 64 + bit; // oldest starving head wins
+            best_head = head;
+          }
+        }
+      }
+      return best;
+    }
+
+    std::optional<QueuedRequest> pop_level_(Clock::time_point now)
+    {
+      for (;;)
+      {
+        const std::size_t p = next_level_(now);
+        if (p == levels)
+          return std::nullopt; // pushes still in flight
+
+        Level &l = *levels_[p].load(std::memory_order_acquire);
+        std::lock_guard<std::mutex> lock(l.mutex);
+        if (l.items.empty())
+          continue; // another consumer emptied it first
+
+        QueuedRequest q = std::move(l.items.front());
+        l.items.pop_front();
+        if (l.items.empty())
+          nonempty_[p / 64].fetch_and(~(std::uint64_t{1} << (p % 64)), std::memory_order_release);
+        else
+          l.head.store(l.items.front().enqueued_at.time_since_epoch().count(), std::memory_order_relaxed);
+        return q;
+      }
+    }
+
+    std::optional<QueuedRequest> pop_edf_()
+    {
+      std::lock_guard<std::mutex> lock(edf_mutex_);
+      if (edf_.empty())
+        return std::nullopt;
+      std::pop_heap(edf_.begin(), edf_.end(), EntryLater{});
+      QueuedRequest q = std::move(edf_.back().item);
+      edf_.pop_back();
+      return q;
+    }
+
+    /// @pre x != 0
+    static int count_leading_zeros_(std::uint64_t x)
+    {
+      int n = 0;
+      for (std::uint64_t bit = std::uint64_t{1} << 63; (x & bit) == 0; bit >>= 1)
+        ++n;
+      return n;
+    }
+
+    /// CoDel controller state for one target.
+    struct CodelState
+    {
+      std::chrono::microseconds target{0};
+      Clock::time_point first_above{};
+      Clock::time_point drop_next{};
+      std::uint32_t drop_count = 0;
+      bool dropping = false;
+    };
+
+    /// State of `target`'s controller (few distinct targets: linear scan).
+    CodelState &codel_state_(std::chrono::microseconds target)
+    {
+      for (CodelState &st : codel_)
+      {
+        if (st.target == target)
+          return st;
+      }
+      codel_.push_back(CodelState{target});
+      return codel_.back();
+    }
+
+    /// CoDel control law, evaluated on each dequeued head against the
+    /// controller of its own target.
+    bool codel_should_drop_(const QueuedRequest &q, Clock::time_point now)
+    {
+      CodelState &st = codel_state_(q.codel_target);
+      const auto sojourn = now - q.enqueued_at;
+
+      bool above = false;
+      if (sojourn < st.target || size_.load(std::memory_order_acquire) == 0)
+      {
+        // Below target, or the queue just drained: no standing queue.
+        st.first_above = Clock::time_point{};
+      }
+      else if (st.first_above == Clock::time_point{})
+      {
+        st.first_above = now + cfg_.codel_interval;
+      }
+      else if (now >= st.first_above)
+      {
+        above = true;
+      }
+
+      if (st.dropping)
+      {
+        if (!above)
+        {
+          st.dropping = false;
+          return false;
+        }
+        if (now >= st.drop_next)
+        {
+          ++st.drop_count;
+          st.drop_next = now + codel_step_(st.drop_count);
+          return true;
+        }
+        return false;
+      }
+
+      if (above)
+      {
+        st.dropping = true;
+        // Resume near the previous drop rate if we were shedding recently.
+        st.drop_count = (st.drop_count > 2 && now - st.drop_next < 16 * cfg_.codel_interval) ? st.drop_count - 2 : 1;
+        st.drop_next = now + codel_step_(st.drop_count);
+        return true;
+      }
+      return false;
+    }
+
+    /// interval / sqrt(count)
+    std::chrono::microseconds codel_step_(std::uint32_t drop_count) const
+    {
+      const double n = static_cast<double>(drop_count == 0 ? 1 : drop_count);
+      return std::chrono::microseconds(
+          static_cast<std::int64_t>(static_cast<double>(cfg_.codel_interval.count()) / std::sqrt(n)));
+    }
+
+    const Router *router_;
+    Config cfg_{};
+
+    std::mutex codel_mutex_;
+    std::vector<CodelState> codel_; // one per distinct codel target, guarded by codel_mutex_
+
+    std::array<std::atomic<Level *>, levels> levels_{};  // StrictPriority classes, owned
+    std::array<std::atomic<std::uint64_t>, levels / 64> nonempty_{}; // bit p: class p has items
+
+    std::mutex edf_mutex_;
+    std::vector<Entry> edf_; // min-heap on (deadline, seq), guarded by edf_mutex_
+    std::uint64_t seq_ = 0;
+
+    std::atomic<std::size_t> size_{0};
+  };
+
+} // namespace micro_router
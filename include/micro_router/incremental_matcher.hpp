@@ -0,0 +1,340 @@
+#pragma once
+
+/**
+ * @file incremental_matcher.hpp
+ * @brief Route a request target while it is still arriving (header-only).
+ *
+ * Feed the target bytes in whatever pieces recv() delivers; the matcher
+ * keeps its position between feeds and narrows the candidate routes as
+ * bytes come in, without reassembling the path:
+ *
+ * @code
+ * micro_router::IncrementalMatcher m(router, Method::Get);
+ *
+ * while (m.feed(next_recv_piece()) == IncrementalMatcher::Status::Pending && !m.ended())
+ *   ;
+ * // NoMatch / MethodNotAllowed / TooLong can be answered right away,
+ * // before headers are read.
+ *
+ * if (m.finish(&headers) == IncrementalMatcher::Status::Matched)
+ *   auto span = m.param("id"); // offset + size in the fed byte stream
+ * @endcode
+ *
+ * Notes:
+ * - Feed the request target only; '?' or ' ' ends the path and anything
+ *   after it is ignored, so feeding the rest of a request line is fine.
+ * - Results agree with Router::match: same slash handling, same
+ *   precedence (lowest route id), header predicates checked in finish().
+ * - MethodNotAllowed means routes for other methods can still match the
+ *   path, but none for this method can.
+ * - Router limits on path bytes and segments answer TooLong (414) as soon
+ *   as they are crossed; like Router, only path bytes (before '?') count.
+ *   max_param_bytes is left to the final dispatch.
+ * - The router must outlive the matcher and not change while it is used.
+ */
+
+#include <micro_router/micro_router.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace micro_router
+{
+  /**
+   * @brief Matches one request target fed in pieces; reusable via reset().
+   */
+  class IncrementalMatcher final
+  {
+  public:
+    enum class Status : std::uint8_t
+    {
+      Pending,          // more bytes needed
+      Matched,          // finish() found a route
+      NoMatch,          // no route can match (404)
+      MethodNotAllowed, // only routes for other methods can match (405)
+      TooLong           // over the router's Limits (414)
+    };
+
+    /// Byte range of one path segment in the fed stream.
+    struct Span
+    {
+      std::size_t offset = 0;
+      std::size_t size = 0;
+    };
+
+    IncrementalMatcher(const Router &router, Method method) : router_(&router) { reset(method); }
+
+    /**
+     * @brief Start over for a new request (keeps allocated capacity).
+     *
+     * No route is visited here: candidates are collected once the first
+     * path bytes arrive, already narrowed by them.
+     */
+    void reset(Method method)
+    {
+      method_ = method;
+      candidates_.clear();
+      spans_.clear();
+      seeded_ = false;
+      allowed_ = 0;
+      fed_ = 0;
+      off_ = 0;
+      pending_slashes_ = 0;
+      started_ = false;
+      ended_ = false;
+      route_id_ = Router::npos;
+      status_ = Status::Pending;
+    }
+
+    /**
+     * @brief Consume the next piece of the target.
+     *
+     * @return Pending while a route for `method` can still match.
+     */
+    Status feed(std::string_view bytes)
+    {
+      std::size_t i = 0;
+      while (i < bytes.size() && !ended_ && status_ == Status::Pending)
+      {
+        const char c = bytes[i];
+        if (c == '?' || c == ' ')
+        {
+          ended_ = true;
+          break;
+        }
+        if (detail::is_slash(c))
+        {
+          if (started_)
+            ++pending_slashes_;
+          ++i;
+          ++fed_;
+          continue;
+        }
+
+        std::size_t j = i + 1;
+        while (j < bytes.size() && !detail::is_slash(bytes[j]) && bytes[j] != '?' && bytes[j] != ' ')
+          ++j;
+
+        piece_(bytes.substr(i, j - i));
+        fed_ += j - i;
+        i = j;
+      }
+
+      const Limits &lim = router_->limits();
+      if (status_ == Status::Pending && lim.max_path_bytes != 0 && fed_ > lim.max_path_bytes)
+        status_ = Status::TooLong;
+      return status_;
+    }
+
+    /**
+     * @brief The target is complete: pick the route.
+     *
+     * Header predicates are evaluated against `headers` (lowercase names).
+     */
+    Status finish(const Headers *headers = nullptr)
+    {
+      if (status_ != Status::Pending) // an early verdict stands: feeding stopped there
+        return status_;
+
+      if (started_)
+        close_segment_();
+      else
+        seed_([&](std::size_t id)
+              { return router_->route_segments(id).empty(); });
+
+      const std::size_t depth = spans_.size();
+      bool path_matched = false;
+      bool method_allowed = false;
+      for (const std::size_t id : candidates_)
+      {
+        if (router_->route_segments(id).size() != depth)
+          continue;
+        path_matched = true;
+
+        if (!detail::method_matches(router_->route_method(id), method_))
+          continue;
+        method_allowed = true;
+
+        if (!headers_match_(id, headers))
+          continue;
+
+        route_id_ = id;
+        status_ = Status::Matched;
+        return status_;
+      }
+
+      status_ = path_matched && !method_allowed ? Status::MethodNotAllowed : Status::NoMatch;
+      return status_;
+    }
+
+    Status status() const noexcept { return status_; }
+
+    /// True once '?' or ' ' ended the path (more feeds are ignored).
+    bool ended() const noexcept { return ended_; }
+
+    /// Matched route id (npos until finish() returns Matched).
+    std::size_t route_id() const noexcept { return route_id_; }
+
+    /// Path segments seen so far.
+    const std::vector<Span> &segments() const noexcept { return spans_; }
+
+    /**
+     * @brief Where param `name` of the matched route sits in the fed stream.
+     */
+    std::optional<Span> param(std::string_view name) const
+    {
+      if (route_id_ == Router::npos)
+        return std::nullopt;
+
+      const auto &segs = router_->route_segments(route_id_);
+      for (std::size_t i = 0; i < segs.size(); ++i)
+      {
+        if (segs[i].kind == detail::Segment::Kind::Param && segs[i].text == name)
+          return spans_[i];
+      }
+      return std::nullopt;
+    }
+
+  private:
+    /// A run of non-delimiter bytes of the current segment.
+    void piece_(std::string_view piece)
+    {
+      if (!started_ || pending_slashes_ != 0)
+      {
+        if (started_)
+          close_segment_();
+        // "a//b": each extra slash is an empty segment.
+        for (; pending_slashes_ > 1 && status_ == Status::Pending; --pending_slashes_)
+        {
+          open_segment_(fed_);
+          close_segment_();
+        }
+        pending_slashes_ = 0;
+        started_ = true;
+        open_segment_(fed_);
+        if (status_ != Status::Pending)
+          return;
+      }
+
+      const std::size_t seg = spans_.size() - 1;
+      auto mismatch = [&](std::size_t id)
+      {
+        const detail::Segment &s = router_->route_segments(id)[seg];
+        return s.kind == detail::Segment::Kind::Static &&
+               (s.text.size() < off_ + piece.size() || s.text.compare(off_, piece.size(), piece) != 0);
+      };
+
+      if (seeded_)
+        drop_if_(mismatch);
+      else // first bytes of the path: only routes they fit become candidates
+        seed_([&](std::size_t id)
+              { return !router_->route_segments(id).empty() && !mismatch(id); });
+
+      off_ += piece.size();
+      spans_.back().size += piece.size();
+    }
+
+    void open_segment_(std::size_t offset)
+    {
+      spans_.push_back(Span{offset, 0});
+      off_ = 0;
+
+      const Limits &lim = router_->limits();
+      if (lim.max_segments != 0 && spans_.size() > lim.max_segments)
+      {
+        status_ = Status::TooLong;
+        return;
+      }
+
+      const std::size_t depth = spans_.size();
+      if (seeded_)
+        drop_if_([&](std::size_t id)
+                 { return router_->route_segments(id).size() < depth; });
+    }
+
+    void close_segment_()
+    {
+      const std::size_t seg = spans_.size() - 1;
+      drop_if_([&](std::size_t id)
+               {
+                 const detail::Segment &s = router_->route_segments(id)[seg];
+                 return s.kind == detail::Segment::Kind::Static && s.text.size() != off_; });
+    }
+
+    /// First narrowing: collect the live routes `keep` accepts.
+    template <class Pred>
+    void seed_(Pred keep)
+    {
+      seeded_ = true;
+      for (std::size_t id = 0; id < router_->size(); ++id)
+      {
+        if (router_->removed(id) || !keep(id))
+          continue;
+        candidates_.push_back(id);
+        if (detail::method_matches(router_->route_method(id), method_))
+          ++allowed_;
+      }
+      if (status_ != Status::TooLong)
+        update_status_();
+    }
+
+    template <class Pred>
+    void drop_if_(Pred pred)
+    {
+      const auto dropped = [&](std::size_t id)
+      {
+        if (!pred(id))
+          return false;
+        if (detail::method_matches(router_->route_method(id), method_))
+          --allowed_;
+        return true;
+      };
+      candidates_.erase(std::remove_if(candidates_.begin(), candidates_.end(), dropped), candidates_.end());
+      if (status_ != Status::TooLong)
+        update_status_();
+    }
+
+    void update_status_()
+    {
+      if (candidates_.empty())
+        status_ = Status::NoMatch;
+      else if (allowed_ == 0)
+        status_ = Status::MethodNotAllowed;
+      else
+        status_ = Status::Pending;
+    }
+
+    bool headers_match_(std::size_t id, const Headers *headers) const
+    {
+      for (const auto &[name, value] : router_->route_options(id).headers)
+      {
+        if (headers == nullptr)
+          return false;
+        const auto it = headers->find(name);
+        if (it == headers->end() || it->second != value)
+          return false;
+      }
+      return true;
+    }
+
+    const Router *router_;
+    Method method_ = Method::Any;
+    std::vector<std::size_t> candidates_; // live ids still possible, ascending (once seeded_)
+    std::vector<Span> spans_;
+    bool seeded_ = false;     // candidates_ filled from the first path bytes
+    std::size_t allowed_ = 0; // candidates accepting method_, kept up to date by seed_ / drop_if_
+    std::size_t fed_ = 0;     // path bytes consumed
+    std::size_t off_ = 0;     // bytes of the current segment
+    std::size_t pending_slashes_ = 0;
+    bool started_ = false;
+    bool ended_ = false;
+    std::size_t route_id_ = Router::npos;
+    Status status_ = Status::Pending;
+  };
+
+} // namespace micro_router
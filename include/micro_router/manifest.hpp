@@ -0,0 +1,254 @@
+#pragma once
+
+/**
+ * @file manifest.hpp
+ * @brief Route manifest loader: routes from a text file instead of code (header-only).
+ *
+ * Format: one route per line, fields separated by spaces or tabs.
+ * @code
+ * # comment lines and blank lines are ignored
+ * # METHOD  PATTERN                  HANDLER         [OPTIONS...]
+ * GET       /health                  health
+ * GET       /users/:id               users.show      priority=5 deadline_ms=20
+ * POST      /users                   users.create
+ * ANY       /debug/{what}            debug           codel_target_ms=50
+ * POST      /uploads                 uploads.create  max_body_bytes=104857600
+ * @endcode
+ *
+ * - METHOD:  GET POST PUT PATCH DELETE HEAD OPTIONS TRACE CONNECT, any
+ *            token registered with register_method(), or ANY / *
+ * - PATTERN: any micro_router pattern
+ * - HANDLER: name looked up in a HandlerRegistry
+ * - OPTIONS: key=value, mapped onto RouteOptions:
+ *            priority (0-255), deadline_ms, codel_target_ms (each at
+ *            most 86400000, one day), max_body_bytes
+ *
+ * Loading is all-or-nothing: the whole manifest is parsed and validated
+ * first (errors carry the 1-based line number), then registered with a
+ * single Router::add_all. The parser works on string_views over the
+ * manifest buffer; the only allocations are the stored route patterns.
+ */
+
+#include <micro_router/micro_router.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace micro_router
+{
+  /**
+   * @brief Handler name -> Handler, used to bind manifest entries.
+   */
+  using HandlerRegistry = std::map<std::string, Handler, std::less<>>;
+
+  /**
+   * @brief Outcome of loading a manifest.
+   */
+  struct ManifestResult
+  {
+    bool ok = true;
+    std::size_t line = 0; // 1-based line of the first error
+    std::string error;
+    std::size_t routes = 0; // routes added on success
+  };
+
+  namespace detail
+  {
+    inline bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+    /// Pops the next blank-separated token off `line`.
+    inline std::string_view next_token(std::string_view &line)
+    {
+      std::size_t i = 0;
+      while (i < line.size() && is_blank(line[i]))
+        ++i;
+      std::size_t j = i;
+      while (j < line.size() && !is_blank(line[j]))
+        ++j;
+
+      const std::string_view tok = line.substr(i, j - i);
+      line.remove_prefix(j);
+      return tok;
+    }
+
+    inline bool manifest_method(std::string_view s, Method &out)
+    {
+      if (s == "ANY" || s == "*")
+      {
+        out = Method::Any;
+        return true;
+      }
+
+      // Custom tokens are accepted once registered with register_method.
+      const std::optional<Method> m = parse_method(s);
+      if (!m.has_value())
+        return false;
+      out = *m;
+      return true;
+    }
+
+    /// Upper bound of the *_ms options, well inside what steady_clock
+    /// arithmetic can hold.
+    inline constexpr std::uint64_t manifest_max_ms = 24ull * 60 * 60 * 1000;
+
+    /// Applies one key=value option; returns an error message or "" on success.
+    inline std::string_view apply_route_option(std::string_view opt, RouteOptions &o)
+    {
+      const std::size_t eq = opt.find('=');
+      if (eq == std::string_view::npos)
+        return "option must be key=value";
+
+      const std::string_view key = opt.substr(0, eq);
+      std::uint64_t v = 0;
+      if (!parse_uint(opt.substr(eq + 1), v))
+        return "option value must be an unsigned integer";
+
+      if (key == "priority")
+      {
+        if (v > 255)
+          return "priority must be 0-255";
+        o.priority = static_cast<std::uint8_t>(v);
+      }
+      else if ((key == "deadline_ms" || key == "codel_target_ms") && v > manifest_max_ms)
+      {
+        return "option value out of range";
+      }
+      else if (key == "deadline_ms")
+      {
+        o.deadline = std::chrono::milliseconds(v);
+      }
+      else if (key == "codel_target_ms")
+      {
+        o.codel_target = std::chrono::milliseconds(v);
+      }
+      else if (key == "max_body_bytes")
+      {
+        o.max_body_bytes = v;
+      }
+      else
+      {
+        return "unknown option";
+      }
+      return {};
+    }
+  } // namespace detail
+
+  /**
+   * @brief Parse a manifest held in memory and register its routes.
+   *
+   * On error nothing is added to `router`.
+   */
+  inline ManifestResult load_manifest(std::string_view text, const HandlerRegistry &handlers, Router &router)
+  {
+    ManifestResult result;
+    std::vector<RouteSpec> specs;
+
+    auto fail = [&](std::size_t line, std::string msg)
+    {
+      result.ok = false;
+      result.line = line;
+      result.error = std::move(msg);
+      return result;
+    };
+
+    std::size_t line_no = 0;
+    while (!text.empty())
+    {
+      ++line_no;
+
+      const std::size_t nl = text.find('\n');
+      std::string_view line = text.substr(0, nl);
+      text.remove_prefix(nl == std::string_view::npos ? text.size() : nl + 1);
+
+      const std::size_t hash = line.find('#');
+      if (hash != std::string_view::npos)
+        line = line.substr(0, hash);
+
+      const std::string_view method_tok = detail::next_token(line);
+      if (method_tok.empty())
+        continue;
+
+      RouteSpec spec;
+      if (!detail::manifest_method(method_tok, spec.method))
+        return fail(line_no, "unknown method '" + std::string(method_tok) + "'");
+
+      const std::string_view pattern = detail::next_token(line);
+      if (pattern.empty() || pattern.front() != '/')
+        return fail(line_no, "expected a pattern starting with '/'");
+
+      const std::string_view name = detail::next_token(line);
+      if (name.empty())
+        return fail(line_no, "expected a handler name");
+
+      const auto h = handlers.find(name);
+      if (h == handlers.end())
+        return fail(line_no, "unknown handler '" + std::string(name) + "'");
+
+      for (std::string_view opt = detail::next_token(line); !opt.empty(); opt = detail::next_token(line))
+      {
+        const std::string_view err = detail::apply_route_option(opt, spec.options);
+        if (!err.empty())
+          return fail(line_no, std::string(err) + " '" + std::string(opt) + "'");
+      }
+
+      spec.pattern = std::string(pattern);
+      spec.handler = h->second;
+      specs.push_back(std::move(spec));
+    }
+
+    result.routes = specs.size();
+    router.add_all(std::move(specs));
+    return result;
+  }
+
+  /**
+   * @brief Read a manifest file in one pass and register its routes.
+   *
+   * The file is read into a single buffer sized up front; an unreadable
+   * file is reported with line 0.
+   */
+  inline ManifestResult load_manifest_file(const std::string &path, const HandlerRegistry &handlers, Router &router)
+  {
+    auto fail = [&](const char *what)
+    {
+      ManifestResult r;
+      r.ok = false;
+      r.error = std::string(what) + " '" + path + "'";
+      return r;
+    };
+
+    // Directories report a bogus size through tellg(); refuse them up front.
+    std::error_code ec;
+    if (std::filesystem::exists(path, ec) && !std::filesystem::is_regular_file(path, ec))
+      return fail("not a regular file:");
+
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in)
+      return fail("cannot open");
+
+    // -1 for non-seekable streams.
+    const std::streamoff size = in.tellg();
+    if (size < 0)
+      return fail("cannot size");
+
+    std::string buf(static_cast<std::size_t>(size), '\0');
+    in.seekg(0);
+    in.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+    if (in.gcount() != static_cast<std::streamsize>(buf.size()))
+      return fail("short read from");
+
+    return load_manifest(buf, handlers, router);
+  }
+
+} // namespace micro_router
@@ -0,0 +1,186 @@
+#pragma once
+
+/**
+ * @file match_memo.hpp
+ * @brief Per-connection memo of resolved paths for HTTP/2 / HTTP/3 (header-only).
+ *
+ * On a multiplexed connection the same `:path` comes back again and again,
+ * often as an HPACK / QPACK dynamic-table reference. MatchMemo remembers
+ * what a path resolved to (route id + where each param sits in the path),
+ * so a repeat skips tokenization and matching entirely.
+ *
+ * @code
+ * micro_router::MatchMemo memo(router); // one per connection
+ *
+ * // :path decoded from dynamic-table entry `entry` (absolute insert index):
+ * auto id = memo.resolve(entry, Method::Get, path, params);
+ * // decoder evicted that entry:
+ * memo.evict(entry);
+ *
+ * // literal :path: keyed by a fingerprint of the bytes
+ * auto id2 = memo.resolve(Method::Get, path, params);
+ * @endcode
+ *
+ * Notes:
+ * - Keys must name the bytes, not a slot: use an absolute (insertion
+ *   count) index, as HPACK relative indices shift on every insert.
+ * - Fingerprint hits are confirmed by comparing the stored path, so a
+ *   hash collision never yields a wrong route.
+ * - Results that headers can change are never memoized: routes with
+ *   header predicates, and routes reached because an earlier, predicated
+ *   route was skipped (Router::header_dependent). Misses are not memoized
+ *   either.
+ * - Direct-mapped, fixed capacity: memory is bounded per connection.
+ * - Adding or removing routes, or changing the router's Limits, clears
+ *   the memo on its next use.
+ */
+
+#include <micro_router/micro_router.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace micro_router
+{
+  /**
+   * @brief Connection-scoped cache: path (or table entry) -> route + param offsets.
+   */
+  class MatchMemo final
+  {
+  public:
+    explicit MatchMemo(const Router &router, std::size_t capacity = 32)
+        : router_(&router), slots_(capacity == 0 ? 1 : capacity)
+    {
+      snapshot_();
+    }
+
+    /**
+     * @brief Resolve `path`, keyed by a fingerprint of its bytes.
+     *
+     * Same contract as Router::resolve: params view into `path`.
+     */
+    std::size_t resolve(Method method, std::string_view path, ParamViews &params, const Headers *headers = nullptr)
+    {
+      const std::uint64_t key = std::hash<std::string_view>{}(path);
+      return resolve_(Slot::Kind::Fingerprint, key, method, path, params, headers);
+    }
+
+    /**
+     * @brief Resolve `path`, the value of header-table entry `entry`.
+     *
+     * The entry's bytes are trusted to be `path` until evict(entry).
+     */
+    std::size_t resolve(std::uint64_t entry, Method method, std::string_view path, ParamViews &params,
+                        const Headers *headers = nullptr)
+    {
+      return resolve_(Slot::Kind::TableEntry, entry, method, path, params, headers);
+    }
+
+    /**
+     * @brief The header table dropped `entry`; forget it.
+     */
+    void evict(std::uint64_t entry)
+    {
+      Slot &s = slots_[entry % slots_.size()];
+      if (s.kind == Slot::Kind::TableEntry && s.key == entry)
+        s.kind = Slot::Kind::Empty;
+    }
+
+    void clear()
+    {
+      for (Slot &s : slots_)
+        s.kind = Slot::Kind::Empty;
+    }
+
+    std::size_t hits() const noexcept { return hits_; }
+    std::size_t misses() const noexcept { return misses_; }
+
+  private:
+    struct Slot
+    {
+      enum class Kind : std::uint8_t
+      {
+        Empty,
+        Fingerprint,
+        TableEntry
+      };
+
+      Kind kind = Kind::Empty;
+      Method method = Method::Any;
+      std::uint64_t key = 0;
+      std::size_t route_id = 0;
+      std::string path; // fingerprint slots: confirms the hit
+      std::size_t path_size = 0;
+      std::vector<std::pair<std::string_view, std::pair<std::uint32_t, std::uint32_t>>> params; // name -> offset, size
+    };
+
+    std::size_t resolve_(Slot::Kind kind, std::uint64_t key, Method method, std::string_view path, ParamViews &params,
+                         const Headers *headers)
+    {
+      const Limits &lim = router_->limits();
+      if (router_->size() != size_ || router_->live() != live_ || lim.max_path_bytes != limits_.max_path_bytes ||
+          lim.max_segments != limits_.max_segments || lim.max_param_bytes != limits_.max_param_bytes)
+      {
+        clear();
+        snapshot_();
+      }
+
+      Slot &s = slots_[key % slots_.size()];
+      if (s.kind == kind && s.key == key && s.method == method && s.path_size == path.size() &&
+          (kind == Slot::Kind::TableEntry || s.path == path))
+      {
+        ++hits_;
+        params.clear();
+        for (const auto &[name, span] : s.params)
+          params.push_back({name, path.substr(span.first, span.second)});
+        return s.route_id;
+      }
+
+      ++misses_;
+      const std::size_t id = router_->resolve(method, path, params, headers);
+      if (id == Router::npos || router_->header_dependent(id))
+        return id;
+
+      s.kind = kind;
+      s.key = key;
+      s.method = method;
+      s.route_id = id;
+      s.path_size = path.size();
+      if (kind == Slot::Kind::Fingerprint)
+        s.path.assign(path.data(), path.size());
+      else
+        s.path.clear();
+
+      s.params.clear();
+      for (std::size_t i = 0; i < params.size(); ++i)
+      {
+        const auto &[name, value] = params[i];
+        const auto offset = static_cast<std::uint32_t>(value.data() - path.data());
+        s.params.push_back({name, {offset, static_cast<std::uint32_t>(value.size())}});
+      }
+      return id;
+    }
+
+    void snapshot_()
+    {
+      size_ = router_->size();
+      live_ = router_->live();
+      limits_ = router_->limits();
+    }
+
+    const Router *router_;
+    std::vector<Slot> slots_;
+    std::size_t size_ = 0;
+    std::size_t live_ = 0;
+    Limits limits_{};
+    std::size_t hits_ = 0;
+    std::size_t misses_ = 0;
+  };
+
+} // namespace micro_router
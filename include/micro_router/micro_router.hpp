@@ -20,14 +20,23 @@
  * - Trailing slashes are tolerated ("/a/" matches "/a")
  */
 
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 
+#include <algorithm>
+#include <atomic>
 #include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <stdexcept>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -35,6 +44,10 @@ namespace micro_router
 {
   /**
    * @brief HTTP method enum used by the router.
+   *
+   * Values past `Connect` are custom methods (PURGE, PROPFIND, ...) handed
+   * out by `register_method`; every method id is below `max_methods`, so a
+   * set of methods fits in one `std::uint64_t` mask (see `method_bit`).
    */
   enum class Method : std::uint8_t
   {
@@ -45,25 +58,341 @@ namespace micro_router
     Patch,
     Delete_,
     Head,
-    Options
+    Options,
+    Trace,
+    Connect
   };
 
+  /// Upper bound (exclusive) of method ids, builtin and custom.
+  inline constexpr std::size_t max_methods = 64;
+
+  /// Bit of `m` in a method mask. `Any` has bit 0.
+  inline constexpr std::uint64_t method_bit(Method m)
+  {
+    return std::uint64_t{1} << static_cast<std::uint8_t>(m);
+  }
+
+  namespace detail
+  {
+    inline constexpr std::size_t builtin_methods = static_cast<std::size_t>(Method::Connect) + 1;
+
+    /// Custom method names by id; slots are written once, then published by `count`.
+    struct MethodRegistry
+    {
+      std::mutex mutex;
+      std::atomic<std::size_t> count{builtin_methods};
+      std::string names[max_methods];
+    };
+
+    inline MethodRegistry &method_registry()
+    {
+      static MethodRegistry reg;
+      return reg;
+    }
+
+    /// Packs up to 7 chars plus the length (top byte) into an integer so a
+    /// token compares in one go; "GET" and "GET\0" pack differently.
+    inline constexpr std::uint64_t pack_token(std::string_view s)
+    {
+      std::uint64_t v = static_cast<std::uint64_t>(s.size() & 0xFF) << 56;
+      for (std::size_t i = 0; i < s.size() && i < 7; ++i)
+        v |= static_cast<std::uint64_t>(static_cast<unsigned char>(s[i])) << (8 * i);
+      return v;
+    }
+
+    inline std::optional<Method> find_custom_method(std::string_view name)
+    {
+      MethodRegistry &reg = method_registry();
+      const std::size_t n = reg.count.load(std::memory_order_acquire);
+      for (std::size_t id = builtin_methods; id < n; ++id)
+      {
+        if (reg.names[id] == name)
+          return static_cast<Method>(id);
+      }
+      return std::nullopt;
+    }
+  } // namespace detail
+
+  /**
+   * @brief Classify a request-line method token ("GET", "PURGE", ...).
+   *
+   * Builtin methods (3 to 7 chars) are recognized with a single switch on
+   * the token packed with its length into 64 bits; other tokens are looked up among registered custom
+   * methods. Tokens are case-sensitive, as on the wire.
+   * @return std::nullopt for unknown tokens.
+   */
+  inline std::optional<Method> parse_method(std::string_view token)
+  {
+    if (token.size() >= 3 && token.size() <= 7)
+    {
+      const std::uint64_t v = detail::pack_token(token);
+      switch (v)
+      {
+      case detail::pack_token("GET"):
+        return Method::Get;
+      case detail::pack_token("PUT"):
+        return Method::Put;
+      case detail::pack_token("POST"):
+        return Method::Post;
+      case detail::pack_token("HEAD"):
+        return Method::Head;
+      case detail::pack_token("PATCH"):
+        return Method::Patch;
+      case detail::pack_token("TRACE"):
+        return Method::Trace;
+      case detail::pack_token("DELETE"):
+        return Method::Delete_;
+      case detail::pack_token("OPTIONS"):
+        return Method::Options;
+      case detail::pack_token("CONNECT"):
+        return Method::Connect;
+      default:
+        break;
+      }
+    }
+    return detail::find_custom_method(token);
+  }
+
+  /**
+   * @brief Register (or look up) a custom method token such as "PURGE".
+   *
+   * Ids are dense and stable for the life of the process. Registration is
+   * meant for startup; it is thread-safe, and parse_method may run
+   * concurrently.
+   * @return std::nullopt if the token is empty or all ids are taken.
+   */
+  inline std::optional<Method> register_method(std::string_view token)
+  {
+    if (token.empty())
+      return std::nullopt;
+    if (auto m = parse_method(token))
+      return m;
+
+    detail::MethodRegistry &reg = detail::method_registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    if (auto m = detail::find_custom_method(token)) // lost a race
+      return m;
+
+    const std::size_t id = reg.count.load(std::memory_order_relaxed);
+    if (id >= max_methods)
+      return std::nullopt;
+
+    reg.names[id] = std::string(token);
+    reg.count.store(id + 1, std::memory_order_release);
+    return static_cast<Method>(id);
+  }
+
+  /**
+   * @brief Wire token of a method ("GET", "PURGE"...); "*" for Any, "" if unknown.
+   */
+  inline std::string_view method_name(Method m)
+  {
+    static constexpr std::string_view builtin[] = {
+        "*", "GET", "POST", "PUT", "PATCH", "DELETE", "HEAD", "OPTIONS", "TRACE", "CONNECT"};
+
+    const auto id = static_cast<std::size_t>(m);
+    if (id < detail::builtin_methods)
+      return builtin[id];
+
+    detail::MethodRegistry &reg = detail::method_registry();
+    if (id < reg.count.load(std::memory_order_acquire))
+      return reg.names[id];
+    return {};
+  }
+
   /**
    * @brief Route parameters map (name -> value).
    */
   using Params = std::unordered_map<std::string, std::string>;
 
+  /**
+   * @brief Request headers map (lowercase name -> value).
+   *
+   * Only consulted by routes registered with `RouteOptions::headers`.
+   */
+  using Headers = std::unordered_map<std::string, std::string>;
+
+  struct RouteOptions;
+
+  /**
+   * @brief Router-level request limits, checked before any matching work.
+   *
+   * 0 means unlimited. Rejections answer `status` in the Response:
+   * - path longer than max_path_bytes         -> 414 (bytes before '?';
+   *   the query is never tokenized, bound it with the request line)
+   * - more than max_segments segments         -> 414 (tokenizing stops there)
+   * - a param value longer than max_param_bytes -> 400
+   */
+  struct Limits
+  {
+    std::size_t max_path_bytes = 0;
+    std::size_t max_segments = 0;
+    std::size_t max_param_bytes = 0;
+  };
+
+  /**
+   * @brief Pull-based request body, read from the connection as it arrives.
+   *
+   * The server supplies `pull`, which returns the next chunk as a view into
+   * its receive buffer (an empty view at end of body) and may block until
+   * data is available. Nothing is buffered here: memory stays bounded by
+   * the server's buffer, whatever the body size.
+   *
+   * Flow control: a chunk is reported to `on_consumed(bytes)` once the
+   * handler has moved past it (the next next() call, or as soon as read()
+   * has copied its last byte), so the server can recycle the buffer and
+   * re-arm reads / grant window. The server only receives more when the
+   * handler asks for more. A handler that stops early calls release() (or
+   * drain() to skip the rest, e.g. to keep the connection alive).
+   *
+   * With a limit set (dispatch applies the route's max_body_bytes), reading
+   * past it stops the body and sets too_large().
+   */
+  class BodySource
+  {
+  public:
+    using Pull = std::function<std::string_view()>;
+    using Consumed = std::function<void(std::size_t)>;
+
+    BodySource() = default;
+
+    explicit BodySource(Pull pull, Consumed on_consumed = {}, std::uint64_t limit = 0)
+        : pull_(std::move(pull)), on_consumed_(std::move(on_consumed)), limit_(limit)
+    {
+    }
+
+    /// Next chunk (valid until the next call), or an empty view at the end.
+    std::string_view next()
+    {
+      if (!fetch_())
+        return {};
+
+      const std::string_view out = cur_;
+      cur_ = {};
+      return out;
+    }
+
+    /// Copies up to `cap` bytes into `dst`; returns 0 at the end.
+    std::size_t read(char *dst, std::size_t cap)
+    {
+      if (cap == 0 || !fetch_())
+        return 0;
+
+      const std::size_t n = std::min(cap, cur_.size());
+      std::copy_n(cur_.data(), n, dst);
+      cur_.remove_prefix(n);
+      if (cur_.empty())
+        consumed_();
+      return n;
+    }
+
+    /// Stop reading: reports the pending chunk and ends the body.
+    void release()
+    {
+      cur_ = {};
+      consumed_();
+      done_ = true;
+    }
+
+    /// Pulls and discards the rest of the body; returns the bytes skipped.
+    std::uint64_t drain()
+    {
+      std::uint64_t skipped = cur_.size();
+      cur_ = {};
+      while (fetch_())
+      {
+        skipped += cur_.size();
+        cur_ = {};
+      }
+      return skipped;
+    }
+
+    /// Reads the rest of the body into one string (small bodies only).
+    std::string read_all()
+    {
+      std::string out;
+      for (std::string_view c = next(); !c.empty(); c = next())
+        out.append(c.data(), c.size());
+      return out;
+    }
+
+    void set_limit(std::uint64_t limit) noexcept { limit_ = limit; }
+    std::uint64_t limit() const noexcept { return limit_; }
+
+    /// Bytes pulled from the connection so far.
+    std::uint64_t received() const noexcept { return received_; }
+
+    bool done() const noexcept { return done_ && cur_.empty(); }
+    bool too_large() const noexcept { return too_large_; }
+
+  private:
+    bool fetch_()
+    {
+      if (!cur_.empty())
+        return true;
+
+      consumed_();
+
+      if (done_ || !pull_)
+      {
+        done_ = true;
+        return false;
+      }
+
+      cur_ = pull_();
+      if (cur_.empty())
+      {
+        done_ = true;
+        return false;
+      }
+
+      received_ += cur_.size();
+      chunk_size_ = cur_.size();
+      if (limit_ != 0 && received_ > limit_)
+      {
+        too_large_ = true;
+        done_ = true;
+        cur_ = {};
+        return fetch_();
+      }
+      return true;
+    }
+
+    void consumed_()
+    {
+      if (chunk_size_ == 0)
+        return;
+      if (on_consumed_)
+        on_consumed_(chunk_size_);
+      chunk_size_ = 0;
+    }
+
+    Pull pull_;
+    Consumed on_consumed_;
+    std::uint64_t limit_ = 0;
+    std::uint64_t received_ = 0;
+    std::string_view cur_;       // unread rest of the current chunk
+    std::size_t chunk_size_ = 0; // current chunk, not yet reported consumed
+    bool done_ = false;
+    bool too_large_ = false;
+  };
+
   /**
    * @brief Minimal request shape used by micro_router.
    *
-   * You can adapt this to your server by filling `method` + `path`.
-   * When a route matches, `params` is populated.
+   * You can adapt this to your server by filling `method` + `path`
+   * (+ `headers` if routes use header predicates, with lowercase names).
+   * When a route matches, `params` and `route` are populated.
    */
   struct Request
   {
     Method method = Method::Any;
     std::string path;
-    Params params;
+    Params params{};
+    Headers headers{};
+    const RouteOptions *route = nullptr; // matched route's options / metadata
+    BodySource *body = nullptr;          // streamed body, optional
   };
 
   /**
@@ -83,13 +412,269 @@ namespace micro_router
    */
   using Handler = std::function<void(const Request &, Response &)>;
 
+  namespace detail
+  {
+    inline int hex_value(char c)
+    {
+      if (c >= '0' && c <= '9')
+        return c - '0';
+      if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+      if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+      return -1;
+    }
+
+    /// Percent-decodes a path segment ("%2F" -> "/"). Malformed escapes are
+    /// kept verbatim; '+' is left alone (it only means space in forms).
+    inline std::string percent_decode(std::string_view in)
+    {
+      std::string out;
+      out.reserve(in.size());
+      for (std::size_t i = 0; i < in.size(); ++i)
+      {
+        if (in[i] == '%' && i + 2 < in.size())
+        {
+          const int hi = hex_value(in[i + 1]);
+          const int lo = hex_value(in[i + 2]);
+          if (hi >= 0 && lo >= 0)
+          {
+            out.push_back(static_cast<char>(hi * 16 + lo));
+            i += 2;
+            continue;
+          }
+        }
+        out.push_back(in[i]);
+      }
+      return out;
+    }
+  } // namespace detail
+
+  /**
+   * @brief Route params as borrowed (name, value) views.
+   *
+   * Names point into the router, values into the request target. Up to
+   * `inline_capacity` params are stored without any allocation.
+   */
+  class ParamViews final
+  {
+  public:
+    using value_type = std::pair<std::string_view, std::string_view>;
+
+    static constexpr std::size_t inline_capacity = 8;
+
+    void clear() noexcept
+    {
+      size_ = 0;
+      overflow_.clear();
+      decoded_.clear();
+    }
+
+    void push_back(value_type p)
+    {
+      if (size_ < inline_capacity)
+        inline_[size_] = p;
+      else
+        overflow_.push_back(p);
+      ++size_;
+    }
+
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    const value_type &operator[](std::size_t i) const
+    {
+      return i < inline_capacity ? inline_[i] : overflow_[i - inline_capacity];
+    }
+
+    /// Value of the first param named `name`.
+    std::optional<std::string_view> find(std::string_view name) const
+    {
+      for (std::size_t i = 0; i < size_; ++i)
+      {
+        if ((*this)[i].first == name)
+          return (*this)[i].second;
+      }
+      return std::nullopt;
+    }
+
+    /// Value of `name`, or an empty view if absent.
+    std::string_view get(std::string_view name) const { return find(name).value_or(std::string_view{}); }
+
+    /**
+     * @brief Percent-decoded value of `name`, decoded on first request.
+     *
+     * Values without '%' are returned as-is (no copy). Otherwise the
+     * decoded string is cached here, so it lives as long as these params
+     * (i.e. the request) and later calls are free.
+     */
+    std::string_view decoded(std::string_view name) const
+    {
+      const std::optional<std::string_view> raw = find(name);
+      if (!raw.has_value() || raw->find('%') == std::string_view::npos)
+        return raw.value_or(std::string_view{});
+
+      for (const auto &[n, v] : decoded_)
+      {
+        if (n == name)
+          return v;
+      }
+      // std::list: cached strings never move, so returned views stay valid.
+      decoded_.emplace_back(name, detail::percent_decode(*raw));
+      return decoded_.back().second;
+    }
+
+  private:
+    value_type inline_[inline_capacity]{};
+    std::vector<value_type> overflow_;
+    std::size_t size_ = 0;
+    mutable std::list<std::pair<std::string_view, std::string>> decoded_;
+  };
+
+  /**
+   * @brief Non-owning request shape: everything borrowed from the caller.
+   *
+   * Fill `method` + `path` (the raw request target, query included) straight
+   * from the receive buffer; `dispatch` splits off `query` and fills
+   * `params`. The buffer must outlive the handler call.
+   */
+  struct RequestView
+  {
+    Method method = Method::Any;
+    std::string_view path;
+    std::string_view query;            // set by dispatch from `path`
+    std::string_view host;
+    const Headers *headers = nullptr;  // for header predicates, optional
+    ParamViews params;
+    void *context = nullptr;           // caller's per-request state
+    const RouteOptions *route = nullptr; // set by dispatch
+    BodySource *body = nullptr;        // streamed body, optional
+  };
+
+  /**
+   * @brief Handler signature for routes added with `Router::add_view`.
+   */
+  using ViewHandler = std::function<void(const RequestView &, Response &)>;
+
+  /**
+   * @brief Handler signature for routes added with `Router::add_batch`:
+   * every request of one route in a batch, responses at the same indices.
+   */
+  using BatchHandler = std::function<void(const std::vector<const Request *> &, const std::vector<Response *> &)>;
+
+  /**
+   * @brief Prefix hook (see `Router::hook`): return false to stop the
+   * request, after setting the response (e.g. 401).
+   */
+  using Hook = std::function<bool(const RequestView &, Response &)>;
+
+  /**
+   * @brief Hooks covering one route, outermost prefix first.
+   */
+  using Hooks = std::vector<std::shared_ptr<const Hook>>;
+
+  /**
+   * @brief Optional per-route settings passed to `Router::add`.
+   *
+   * The router itself only stores these; schedulers such as
+   * `DispatchQueue` read them through `Router::route_options(route_id)`.
+   */
+  struct RouteOptions
+  {
+    /// Scheduling class, higher runs first (0 = default / batch).
+    std::uint8_t priority = 0;
+
+    /// Time budget from enqueue to handler start (0 = no deadline).
+    std::chrono::microseconds deadline{0};
+
+    /// Queue-delay target for CoDel admission (0 = use the queue's target).
+    std::chrono::microseconds codel_target{0};
+
+    /// Header predicates: the route only matches requests carrying every
+    /// listed header with exactly this value (names are case-insensitive).
+    /// Register variants of one path, most specific first, e.g.
+    /// {{"accept-version", "2"}} then an unconditioned fallback.
+    std::vector<std::pair<std::string, std::string>> headers{};
+
+    /// Largest request body this route accepts, in bytes (0 = unlimited).
+    /// Checked against content-length by Router::route_head before the body
+    /// is read; servers streaming a chunked body compare their running total.
+    std::uint64_t max_body_bytes = 0;
+
+    /// Per-route metadata for middleware / servers (auth scope, cache
+    /// policy, metrics label...). Not owned: point at storage that outlives
+    /// the router. Read back in O(1) from `Match::options`, `Request::route`
+    /// or `RequestView::route`.
+    const void *user_data = nullptr;
+
+    /// Small inline tag for metadata that fits in an integer (flags, ids).
+    std::uint64_t tag = 0;
+
+    template <class T>
+    const T *data() const noexcept
+    {
+      return static_cast<const T *>(user_data);
+    }
+  };
+
+  /**
+   * @brief One weighted handler of a split route (see `Router::split`).
+   */
+  struct Variant
+  {
+    std::uint32_t weight = 0;
+    Handler handler;
+  };
+
+  /**
+   * @brief How a split route picks its variant.
+   *
+   * With neither key set, each request draws from a per-thread RNG. With a
+   * sticky key, the same param / header value always lands on the same
+   * variant (for a given set of weights).
+   */
+  struct SplitOptions
+  {
+    std::string sticky_param;  // e.g. "userId"
+    std::string sticky_header; // lowercase, e.g. "x-session"
+  };
+
+  /**
+   * @brief One route for bulk registration with `Router::add_all`.
+   */
+  struct RouteSpec
+  {
+    Method method = Method::Any;
+    std::string pattern;
+    Handler handler;
+    RouteOptions options{};
+  };
+
   /**
    * @brief A matched route (internal result).
+   *
+   * `route_id` identifies the matched route inside its Router and can be
+   * handed to `Router::invoke` later, e.g. from a worker thread, without
+   * copying the handler.
    */
   struct Match
   {
     Handler handler;
     Params params;
+    std::size_t route_id = 0;
+    const RouteOptions *options = nullptr; // valid until the router changes
+    Hooks hooks;                           // prefix hooks covering this request, outermost first
+  };
+
+  /**
+   * @brief Per-connection "last matched route" hint.
+   *
+   * Keep one per keep-alive connection and pass it to the hinted
+   * `match` / `resolve` overloads; see `Router::prepare_hints`.
+   */
+  struct RouteHint
+  {
+    std::size_t route_id = static_cast<std::size_t>(-1);
   };
 
   namespace detail
@@ -116,6 +701,14 @@ namespace micro_router
       return p.substr(0, q);
     }
 
+    inline std::string_view query_of(std::string_view p)
+    {
+      const std::size_t q = p.find('?');
+      if (q == std::string_view::npos)
+        return {};
+      return p.substr(q + 1);
+    }
+
     inline std::string_view trim_slashes(std::string_view p)
     {
       // remove leading slashes
@@ -129,19 +722,42 @@ namespace micro_router
       return p;
     }
 
-    inline std::vector<std::string_view> split_segments(std::string_view path)
+    /// Strict unsigned decimal (content-length, manifest options): 1-19
+    /// ASCII digits, nothing else.
+    inline bool parse_uint(std::string_view s, std::uint64_t &out)
     {
-      std::vector<std::string_view> out;
+      if (s.empty() || s.size() > 19)
+        return false;
+
+      std::uint64_t v = 0;
+      for (char c : s)
+      {
+        if (c < '0' || c > '9')
+          return false;
+        v = v * 10 + static_cast<std::uint64_t>(c - '0');
+      }
+      out = v;
+      return true;
+    }
+
+    /// Splits `path` into `out`. With `max_segments` != 0, stops as soon as
+    /// one segment too many is found and returns false.
+    inline bool split_segments(std::string_view path, std::vector<std::string_view> &out, std::size_t max_segments)
+    {
+      out.clear();
 
       path = strip_query(path);
       path = trim_slashes(path);
 
       if (path.empty())
-        return out;
+        return true;
 
       std::size_t i = 0;
       while (i < path.size())
       {
+        if (max_segments != 0 && out.size() == max_segments)
+          return false;
+
         const std::size_t j = path.find('/', i);
         if (j == std::string_view::npos)
         {
@@ -151,10 +767,112 @@ namespace micro_router
         out.push_back(path.substr(i, j - i));
         i = j + 1;
       }
-      return out;
+      return true;
     }
 
-    inline bool is_braced_param(std::string_view s)
+    /**
+     * @brief split_segments over a path given as consecutive fragments.
+     *
+     * A segment inside one fragment is a view into it; only a segment that
+     * spans a fragment boundary is copied, into `scratch`. `scratch` is
+     * reserved once up front so earlier views stay valid.
+     */
+    inline bool split_segments(const std::string_view *frags, std::size_t count, std::vector<std::string_view> &out,
+                               std::string &scratch, std::size_t max_segments)
+    {
+      out.clear();
+      scratch.clear();
+
+      std::size_t total = 0;
+      for (std::size_t f = 0; f < count; ++f)
+        total += frags[f].size();
+      scratch.reserve(total);
+
+      bool started = false;
+      bool in_seg = false;
+      std::size_t empties = 0; // slashes after a segment, pending
+      std::size_t seg_frag = 0;
+      std::size_t seg_off = 0;
+
+      // Segment from (seg_frag, seg_off) up to (f, i), exclusive.
+      auto emit = [&](std::size_t f, std::size_t i)
+      {
+        while (i == 0 && f > seg_frag)
+          i = frags[--f].size();
+
+        if (f == seg_frag)
+        {
+          out.push_back(frags[f].substr(seg_off, i - seg_off));
+          return;
+        }
+
+        const std::size_t at = scratch.size();
+        scratch.append(frags[seg_frag].substr(seg_off));
+        for (std::size_t k = seg_frag + 1; k < f; ++k)
+          scratch.append(frags[k]);
+        scratch.append(frags[f].substr(0, i));
+        out.push_back(std::string_view(scratch).substr(at));
+      };
+
+      for (std::size_t f = 0; f < count; ++f)
+      {
+        const std::string_view frag = frags[f];
+        for (std::size_t i = 0; i < frag.size(); ++i)
+        {
+          const char c = frag[i];
+          if (c == '?')
+          {
+            if (in_seg)
+              emit(f, i);
+            return true;
+          }
+
+          if (is_slash(c))
+          {
+            if (in_seg)
+            {
+              emit(f, i);
+              in_seg = false;
+            }
+            else if (started)
+            {
+              ++empties;
+            }
+            continue;
+          }
+
+          if (in_seg)
+            continue;
+
+          for (; empties != 0; --empties)
+          {
+            if (max_segments != 0 && out.size() == max_segments)
+              return false;
+            out.emplace_back();
+          }
+          if (max_segments != 0 && out.size() == max_segments)
+            return false;
+
+          started = true;
+          in_seg = true;
+          seg_frag = f;
+          seg_off = i;
+        }
+      }
+
+      if (in_seg)
+        emit(count - 1, frags[count - 1].size());
+      return true;
+    }
+
+    inline std::vector<std::string_view> split_segments(std::string_view path)
+    {
+      std::vector<std::string_view> out;
+      split_segments(path, out, 0);
+      return out;
+    }
+
+    inline bool is_braced_param(std::string_view s)
     {
       return s.size() >= 3 && s.front() == '{' && s.back() == '}';
     }
@@ -197,12 +915,105 @@ namespace micro_router
       return segs;
     }
 
+    inline void to_lower(std::string &s)
+    {
+      for (char &c : s)
+      {
+        if (c >= 'A' && c <= 'Z')
+          c = static_cast<char>(c - 'A' + 'a');
+      }
+    }
+
+    inline bool same_segments(const std::vector<Segment> &a, const std::vector<Segment> &b)
+    {
+      if (a.size() != b.size())
+        return false;
+      for (std::size_t i = 0; i < a.size(); ++i)
+      {
+        if (a[i].kind != b[i].kind || a[i].text != b[i].text)
+          return false;
+      }
+      return true;
+    }
+
     inline bool method_matches(Method route_method, Method req_method)
     {
       if (route_method == Method::Any)
         return true;
       return route_method == req_method;
     }
+
+    /// Per-thread xorshift64*, seeded from the thread's stack address.
+    inline std::uint64_t fast_rand()
+    {
+      thread_local std::uint64_t state = 0;
+      if (state == 0)
+      {
+        int anchor = 0;
+        state = reinterpret_cast<std::uintptr_t>(&anchor) * 0x9E3779B97F4A7C15ull | 1;
+      }
+      state ^= state >> 12;
+      state ^= state << 25;
+      state ^= state >> 27;
+      return state * 0x2545F4914F6CDD1Dull;
+    }
+
+    /// Weighted variants of one route. Weights are atomics so they can be
+    /// retuned while other threads dispatch.
+    struct Split
+    {
+      std::vector<Handler> handlers;
+      std::unique_ptr<std::atomic<std::uint32_t>[]> weights;
+      SplitOptions options;
+
+      std::size_t pick(const Params &params, const Headers *headers) const
+      {
+        const std::size_t n = handlers.size();
+
+        std::uint64_t total = 0;
+        for (std::size_t i = 0; i < n; ++i)
+          total += weights[i].load(std::memory_order_relaxed);
+        if (total == 0)
+          return 0;
+
+        const std::string *key = nullptr;
+        if (!options.sticky_param.empty())
+        {
+          const auto it = params.find(options.sticky_param);
+          if (it != params.end())
+            key = &it->second;
+        }
+        else if (!options.sticky_header.empty() && headers != nullptr)
+        {
+          const auto it = headers->find(options.sticky_header);
+          if (it != headers->end())
+            key = &it->second;
+        }
+        const std::uint64_t x = key != nullptr ? std::hash<std::string>{}(*key) * 0x9E3779B97F4A7C15ull : fast_rand();
+
+        std::uint64_t point = x % total;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+          const std::uint64_t w = weights[i].load(std::memory_order_relaxed);
+          if (point < w)
+            return i;
+          point -= w;
+        }
+        return n - 1; // weights changed between the two passes
+      }
+    };
+
+    /// Routes sharing method and path shape that differ only by header
+    /// predicates. When every predicate tests the same header, the winner
+    /// is one hash lookup on that header's value.
+    struct VariantTable
+    {
+      std::vector<std::size_t> members; // ascending route ids
+      bool keyed = false;               // one predicate per route, all on `header`
+      std::string header;
+      std::unordered_map<std::string, std::size_t> by_value; // value -> lowest member requiring it
+      std::size_t fallback = static_cast<std::size_t>(-1);   // lowest member without predicates
+    };
   } // namespace detail
 
   /**
@@ -227,109 +1038,1401 @@ namespace micro_router
     /**
      * @brief Add a route for a given HTTP method and pattern.
      */
-    Router &add(Method method, std::string_view pattern, Handler handler)
+    Router &add(Method method, std::string_view pattern, Handler handler, RouteOptions opts = {})
     {
-      Route r;
-      r.method = method;
-      r.pattern = std::string(pattern);
-      r.segments = detail::parse_pattern(pattern);
-      r.handler = std::move(handler);
-      routes_.push_back(std::move(r));
+      routes_.push_back(make_route_(method, std::string(pattern), std::move(handler), std::move(opts)));
+      ++live_;
+      index_(routes_.size() - 1);
+      collect_hooks_(routes_.back());
+      return *this;
+    }
+
+    /**
+     * @brief Add a route whose handler runs on borrowed memory.
+     *
+     * Dispatching a RequestView to it copies nothing. It can still be
+     * reached through the Request API (match, dispatch(Request&), invoke),
+     * which presents the Request as a view. Either way `params` lists the
+     * pattern's params in segment order.
+     */
+    Router &add_view(Method method, std::string_view pattern, ViewHandler handler, RouteOptions opts = {})
+    {
+      // Param names in pattern order, so view params keep segment order.
+      std::vector<std::string> names;
+      for (auto &seg : detail::parse_pattern(pattern))
+      {
+        if (seg.kind == detail::Segment::Kind::Param)
+          names.push_back(std::move(seg.text));
+      }
+
+      Handler adapter = [h = handler, names = std::move(names)](const Request &req, Response &res)
+      {
+        RequestView v;
+        v.method = req.method;
+        v.path = req.path;
+        v.query = detail::query_of(v.path);
+        v.headers = &req.headers;
+        v.route = req.route;
+        for (const auto &name : names)
+        {
+          const auto it = req.params.find(name);
+          v.params.push_back({name, it != req.params.end() ? std::string_view(it->second) : std::string_view{}});
+        }
+        h(v, res);
+      };
+
+      add(method, pattern, std::move(adapter), std::move(opts));
+      routes_.back().view_handler = std::move(handler);
+      return *this;
+    }
+
+    /**
+     * @brief Add a route that handles its requests of a batch in one call.
+     *
+     * dispatch_batch hands it all of its requests at once (e.g. to merge
+     * backend lookups); every other entry point calls it with one request.
+     */
+    Router &add_batch(Method method, std::string_view pattern, BatchHandler handler, RouteOptions opts = {})
+    {
+      Handler adapter = [h = handler](const Request &req, Response &res)
+      { h({&req}, {&res}); };
+
+      add(method, pattern, std::move(adapter), std::move(opts));
+      routes_.back().batch_handler = std::move(handler);
+      return *this;
+    }
+
+    /**
+     * @brief Add many routes at once, in order (same ids as repeated `add`).
+     *
+     * Patterns are parsed in parallel on up to `threads` threads
+     * (0 = hardware concurrency) straight into pre-sized storage, then the
+     * depth index is rebuilt once with exact bucket sizes. Small batches
+     * are parsed on the calling thread.
+     */
+    Router &add_all(std::vector<RouteSpec> specs, std::size_t threads = 0)
+    {
+      const std::size_t base = routes_.size();
+      const std::size_t n = specs.size();
+      routes_.resize(base + n);
+
+      auto build = [&](std::size_t begin, std::size_t end)
+      {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+          RouteSpec &spec = specs[i];
+          routes_[base + i] = make_route_(spec.method, std::move(spec.pattern), std::move(spec.handler), std::move(spec.options));
+        }
+      };
+
+      constexpr std::size_t min_chunk = 4096;
+      if (threads == 0)
+        threads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+      threads = std::min(threads, std::max<std::size_t>(1, n / min_chunk));
+
+      if (threads <= 1)
+      {
+        build(0, n);
+      }
+      else
+      {
+        const std::size_t chunk = (n + threads - 1) / threads;
+        std::vector<std::thread> workers;
+        workers.reserve(threads - 1);
+        for (std::size_t t = 1; t < threads; ++t)
+          workers.emplace_back(build, std::min(n, t * chunk), std::min(n, (t + 1) * chunk));
+        build(0, std::min(n, chunk));
+        for (auto &w : workers)
+          w.join();
+      }
+
+      live_ += n;
+      reindex_();
+      if (!prefix_hooks_.empty())
+      {
+        for (std::size_t i = base; i < routes_.size(); ++i)
+          collect_hooks_(routes_[i]);
+      }
+      return *this;
+    }
+
+    /**
+     * @brief Run `hook` before the handler of every route under `prefix`.
+     *
+     * A route is under "/admin" if its pattern starts with that segment
+     * ("/admin", "/admin/users/:id"); param segments in the prefix accept
+     * any route segment. A param segment in the route ("/:section/settings")
+     * may carry the prefix text, so the hook covers it too and is run only
+     * for requests whose value decodes to "admin" (so "%61dmin" counts).
+     * Coverage is worked out here,
+     * against the patterns, for routes added before and after this call;
+     * `Match::hooks` lists the hooks that apply to the matched request.
+     *
+     * dispatch, dispatch_batch and invoke run the hooks outermost prefix
+     * first (registration order on ties). A hook returning false stops the
+     * request: the handler does not run, dispatch still returns true.
+     */
+    Router &hook(std::string_view prefix, Hook hook)
+    {
+      PrefixHook ph;
+      ph.segments = detail::parse_pattern(prefix);
+      ph.hook = std::make_shared<const Hook>(std::move(hook));
+      prefix_hooks_.push_back(std::move(ph));
+
+      for (Route &r : routes_)
+      {
+        if (!r.removed)
+          collect_hooks_(r);
+      }
       return *this;
     }
 
     /// Convenience helpers
-    Router &any(std::string_view pattern, Handler handler) { return add(Method::Any, pattern, std::move(handler)); }
-    Router &get(std::string_view pattern, Handler handler) { return add(Method::Get, pattern, std::move(handler)); }
-    Router &post(std::string_view pattern, Handler handler) { return add(Method::Post, pattern, std::move(handler)); }
-    Router &put(std::string_view pattern, Handler handler) { return add(Method::Put, pattern, std::move(handler)); }
-    Router &patch(std::string_view pattern, Handler handler) { return add(Method::Patch, pattern, std::move(handler)); }
-    Router &del(std::string_view pattern, Handler handler) { return add(Method::Delete_, pattern, std::move(handler)); }
-    Router &head(std::string_view pattern, Handler handler) { return add(Method::Head, pattern, std::move(handler)); }
-    Router &options(std::string_view pattern, Handler handler) { return add(Method::Options, pattern, std::move(handler)); }
+    Router &any(std::string_view pattern, Handler handler, RouteOptions opts = {}) { return add(Method::Any, pattern, std::move(handler), std::move(opts)); }
+    Router &get(std::string_view pattern, Handler handler, RouteOptions opts = {}) { return add(Method::Get, pattern, std::move(handler), std::move(opts)); }
+    Router &post(std::string_view pattern, Handler handler, RouteOptions opts = {}) { return add(Method::Post, pattern, std::move(handler), std::move(opts)); }
+    Router &put(std::string_view pattern, Handler handler, RouteOptions opts = {}) { return add(Method::Put, pattern, std::move(handler), std::move(opts)); }
+    Router &patch(std::string_view pattern, Handler handler, RouteOptions opts = {}) { return add(Method::Patch, pattern, std::move(handler), std::move(opts)); }
+    Router &del(std::string_view pattern, Handler handler, RouteOptions opts = {}) { return add(Method::Delete_, pattern, std::move(handler), std::move(opts)); }
+    Router &head(std::string_view pattern, Handler handler, RouteOptions opts = {}) { return add(Method::Head, pattern, std::move(handler), std::move(opts)); }
+    Router &options(std::string_view pattern, Handler handler, RouteOptions opts = {}) { return add(Method::Options, pattern, std::move(handler), std::move(opts)); }
+    Router &trace(std::string_view pattern, Handler handler, RouteOptions opts = {}) { return add(Method::Trace, pattern, std::move(handler), std::move(opts)); }
+    Router &connect(std::string_view pattern, Handler handler, RouteOptions opts = {}) { return add(Method::Connect, pattern, std::move(handler), std::move(opts)); }
+
+    /**
+     * @brief Sentinel route id meaning "no route".
+     */
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
 
     /**
      * @brief Try to match a request path against registered routes.
+     *
+     * Routes with header predicates only match through the overload taking
+     * `headers`.
      * @return A Match if found, otherwise std::nullopt.
      */
     std::optional<Match> match(Method method, std::string_view path) const
     {
-      const auto parts = detail::split_segments(path);
+      return match_(method, path, nullptr);
+    }
 
-      for (const auto &r : routes_)
+    std::optional<Match> match(Method method, std::string_view path, const Headers &headers) const
+    {
+      return match_(method, path, &headers);
+    }
+
+    /**
+     * @brief match() over a target split across buffers (iovec, ring slots).
+     *
+     * Tokenizes across fragment boundaries without joining them; only a
+     * segment spanning a boundary is copied, into local scratch.
+     */
+    std::optional<Match> match(Method method, const std::string_view *fragments, std::size_t count,
+                               const Headers *headers = nullptr) const
+    {
+      std::vector<std::string_view> parts;
+      std::string scratch;
+      int status = 0;
+
+      return make_match_(lookup_(method, fragments, count, headers, parts, scratch, status), parts, headers);
+    }
+
+    /**
+     * @brief Dispatches to the first matching route and calls its handler.
+     *
+     * - Header predicates are evaluated against req.headers.
+     * - Populates req.params with extracted params.
+     * - Requests over the router's Limits get res.status 414 / 400.
+     * - Returns true if a route matched and handler was called.
+     */
+    bool dispatch(Request &req, Response &res) const
+    {
+      std::vector<std::string_view> parts;
+      int status = 0;
+
+      const std::size_t id = lookup_(req.method, req.path, &req.headers, parts, status);
+      if (id == npos)
       {
-        if (!detail::method_matches(r.method, method))
-          continue;
-        if (r.segments.size() != parts.size())
-          continue;
+        if (status != 0)
+          res.status = status;
+        return false;
+      }
+
+      // parts views into req.path: extract before handing req to the handler.
+      req.params = extract_params_(routes_[id], parts);
+      req.route = &routes_[id].options;
+      limit_body_(routes_[id], req.body);
+      if (run_hooks_(routes_[id], req, res))
+        handler_for_(routes_[id], req.params, &req.headers)(req, res);
+      return true;
+    }
 
-        Params params;
-        bool ok = true;
+    /**
+     * @brief Dispatch a batch (pipelined / queued requests) grouped by route.
+     *
+     * Matches every request first, then runs each route's requests back to
+     * back, in arrival order within the route, so one handler's code stays
+     * hot instead of alternating between handlers. Routes added with
+     * `add_batch` get their whole group in one call.
+     *
+     * `responses` is resized to `reqs.size()`; responses[i] answers reqs[i]
+     * whatever the execution order. Unmatched requests get 404 (or the
+     * Limits status). Prefix hooks run per request during matching.
+     * @return Number of requests that reached their handler.
+     */
+    std::size_t dispatch_batch(std::vector<Request> &reqs, std::vector<Response> &responses) const
+    {
+      responses.assign(reqs.size(), Response{});
+
+      std::vector<std::pair<std::size_t, std::size_t>> order; // (route id, request index)
+      order.reserve(reqs.size());
+
+      std::vector<std::string_view> parts;
+      for (std::size_t i = 0; i < reqs.size(); ++i)
+      {
+        Request &req = reqs[i];
+        int status = 0;
 
-        for (std::size_t i = 0; i < r.segments.size(); ++i)
+        const std::size_t id = lookup_(req.method, req.path, &req.headers, parts, status);
+        if (id == npos)
         {
-          const auto &seg = r.segments[i];
-          const std::string_view value = parts[i];
+          responses[i].status = status != 0 ? status : 404;
+          continue;
+        }
+
+        req.params = extract_params_(routes_[id], parts);
+        req.route = &routes_[id].options;
+        limit_body_(routes_[id], req.body);
+        if (run_hooks_(routes_[id], req, responses[i]))
+          order.emplace_back(id, i);
+      }
 
-          if (seg.kind == detail::Segment::Kind::Static)
+      // Pairs sort by route id, then arrival: a stable grouping.
+      std::sort(order.begin(), order.end());
+
+      std::vector<const Request *> group_reqs;
+      std::vector<Response *> group_res;
+      for (std::size_t g = 0; g < order.size();)
+      {
+        const Route &r = routes_[order[g].first];
+        std::size_t end = g;
+        while (end < order.size() && order[end].first == order[g].first)
+          ++end;
+
+        if (r.batch_handler)
+        {
+          group_reqs.clear();
+          group_res.clear();
+          for (std::size_t k = g; k < end; ++k)
           {
-            if (value != seg.text)
-            {
-              ok = false;
-              break;
-            }
+            group_reqs.push_back(&reqs[order[k].second]);
+            group_res.push_back(&responses[order[k].second]);
           }
-          else
+          r.batch_handler(group_reqs, group_res);
+        }
+        else
+        {
+          for (std::size_t k = g; k < end; ++k)
           {
-            // Param segment
-            params.emplace(seg.text, std::string(value));
+            const Request &req = reqs[order[k].second];
+            handler_for_(r, req.params, &req.headers)(req, responses[order[k].second]);
           }
         }
+        g = end;
+      }
+
+      return order.size();
+    }
 
-        if (ok)
+    /**
+     * @brief Route from the request line and headers alone, before the body.
+     *
+     * Lets a server decide what to do with the body before reading it:
+     * @code
+     * const std::size_t id = router.route_head(req, res);
+     * if (id == Router::npos)
+     *   return send(res.status == 200 ? 404 : res.status);  // 413 / 414 / 400
+     * read_body(req.route->max_body_bytes);
+     * router.invoke(id, req, res);
+     * @endcode
+     *
+     * - On a match, req.params and req.route are set; no handler runs.
+     * - A content-length over the route's max_body_bytes answers 413, an
+     *   unparsable one 400; both return npos.
+     * - Limits rejections answer 414 / 400 as in dispatch().
+     * @return The matched route id, or npos.
+     */
+    std::size_t route_head(Request &req, Response &res) const
+    {
+      std::vector<std::string_view> parts;
+      int status = 0;
+
+      const std::size_t id = lookup_(req.method, req.path, &req.headers, parts, status);
+      if (id == npos)
+      {
+        if (status != 0)
+          res.status = status;
+        return npos;
+      }
+
+      const Route &r = routes_[id];
+      if (r.options.max_body_bytes != 0)
+      {
+        const auto it = req.headers.find("content-length");
+        if (it != req.headers.end())
         {
-          Match m;
-          m.handler = r.handler;
-          m.params = std::move(params);
-          return m;
+          std::uint64_t n = 0;
+          if (!detail::parse_uint(it->second, n))
+          {
+            res.status = 400;
+            return npos;
+          }
+          if (n > r.options.max_body_bytes)
+          {
+            res.status = 413;
+            return npos;
+          }
         }
       }
 
-      return std::nullopt;
+      req.params = extract_params_(r, parts);
+      req.route = &r.options;
+      limit_body_(r, req.body);
+      return id;
     }
 
     /**
-     * @brief Dispatches to the first matching route and calls its handler.
+     * @brief Reject oversized requests before matching (see Limits).
+     */
+    Router &set_limits(Limits limits)
+    {
+      if (limits.max_segments != limits_.max_segments)
+        segments_from_routes_ = false;
+      limits_ = limits;
+      return *this;
+    }
+
+    const Limits &limits() const noexcept { return limits_; }
+
+    /**
+     * @brief Cap max_segments at the deepest registered route.
      *
-     * - Populates req.params with extracted params.
-     * - Returns true if a route matched and handler was called.
+     * A path with more segments cannot match anything, so tokenizing stops
+     * right there. The cap then follows the live routes: add() raises it
+     * for a deeper route and remove() lowers it, until set_limits() is
+     * given a different max_segments.
      */
-    bool dispatch(Request &req, Response &res) const
+    Router &limit_segments_to_routes()
     {
-      std::optional<Match> m = match(req.method, req.path);
-      if (!m.has_value())
-        return false;
+      segments_from_routes_ = true;
+      sync_segment_limit_();
+      return *this;
+    }
 
-      req.params = std::move(m->params);
-      m->handler(req, res);
-      return true;
+    /**
+     * @brief Cheapest lookup: route id + param views, nothing materialized.
+     *
+     * Records only where each param sits in `path`; no Params map, no
+     * handler copy, no string copies. Decode on demand with
+     * `params.decoded(name)`. Views are valid while `path` is.
+     * @return The matched route id, or npos.
+     */
+    std::size_t resolve(Method method, std::string_view path, ParamViews &params,
+                        const Headers *headers = nullptr) const
+    {
+      std::vector<std::string_view> parts;
+      int status = 0;
+
+      const std::size_t id = lookup_(method, path, headers, parts, status);
+      if (id != npos)
+        fill_param_views_(routes_[id], parts, params);
+      return id;
     }
 
     /**
-     * @brief Number of registered routes.
+     * @brief resolve() over a target split across buffers.
+     *
+     * Params inside one fragment are views into it; a param spanning a
+     * boundary is copied into `scratch`, which must outlive `params`.
+     * Reuse one scratch per connection to avoid allocations.
      */
-    std::size_t size() const noexcept { return routes_.size(); }
+    std::size_t resolve(Method method, const std::string_view *fragments, std::size_t count, ParamViews &params,
+                        std::string &scratch, const Headers *headers = nullptr) const
+    {
+      std::vector<std::string_view> parts;
+      int status = 0;
 
-  private:
-    struct Route
+      const std::size_t id = lookup_(method, fragments, count, headers, parts, scratch, status);
+      if (id != npos)
+        fill_param_views_(routes_[id], parts, params);
+      return id;
+    }
+
+    /**
+     * @brief Precompute what the last-route hints need.
+     *
+     * For each route, records the earlier routes that could match the same
+     * requests (same depth, compatible method, no conflicting static
+     * segment). A hinted lookup then checks the hinted route plus those
+     * few instead of scanning, and still returns exactly what match()
+     * would. Cost is quadratic in the routes per depth, so it is opt-in;
+     * only routes added since the last call are processed. Routes added
+     * later fall back to the full lookup until the next call.
+     */
+    Router &prepare_hints()
     {
-      Method method = Method::Any;
-      std::string pattern;
-      std::vector<detail::Segment> segments;
-      Handler handler;
-    };
+      for (std::size_t id = hinted_; id < routes_.size(); ++id)
+      {
+        Route &b = routes_[id];
+        b.shadows.clear();
+        if (b.removed)
+          continue;
+
+        for (const std::size_t a : by_depth_[b.segments.size()])
+        {
+          if (a >= id)
+            break;
+          if (overlaps_(routes_[a], b))
+            b.shadows.push_back(a);
+        }
+      }
+      hinted_ = routes_.size();
+      return *this;
+    }
+
+    /**
+     * @brief match(), checking the connection's last route first.
+     *
+     * `hint` is updated to the matched route. Same result as match().
+     */
+    std::optional<Match> match(Method method, std::string_view path, RouteHint &hint,
+                               const Headers *headers = nullptr) const
+    {
+      std::vector<std::string_view> parts;
+      int status = 0;
+
+      const std::size_t id = lookup_(method, path, headers, parts, status, &hint);
+      if (id != npos)
+        hint.route_id = id;
+      return make_match_(id, parts, headers);
+    }
+
+    /**
+     * @brief resolve(), checking the connection's last route first.
+     */
+    std::size_t resolve(Method method, std::string_view path, ParamViews &params, RouteHint &hint,
+                        const Headers *headers = nullptr) const
+    {
+      std::vector<std::string_view> parts;
+      int status = 0;
+
+      const std::size_t id = lookup_(method, path, headers, parts, status, &hint);
+      if (id != npos)
+      {
+        hint.route_id = id;
+        fill_param_views_(routes_[id], parts, params);
+      }
+      return id;
+    }
+
+    /**
+     * @brief Dispatch a borrowed request.
+     *
+     * Sets `req.query` (from `path`), `req.params` and `req.route` on every
+     * call, so one view can be reused across requests; on a miss params are
+     * empty and `route` is null. Routes added with `add_view` run on the
+     * view directly; plain Handler routes get a Request materialized for
+     * them.
+     * @return true if a route matched and its handler was called.
+     */
+    bool dispatch(RequestView &req, Response &res) const
+    {
+      req.query = detail::query_of(req.path);
+      req.params.clear();
+      req.route = nullptr;
+
+      std::vector<std::string_view> parts;
+      int status = 0;
+
+      const std::size_t id = lookup_(req.method, req.path, req.headers, parts, status);
+      if (id == npos)
+      {
+        if (status != 0)
+          res.status = status;
+        return false;
+      }
+
+      const Route &r = routes_[id];
+      fill_param_views_(r, parts, req.params);
+      req.route = &r.options;
+      limit_body_(r, req.body);
+
+      for (const auto &h : r.hooks)
+      {
+        if (covers_(h, req.params) && !(*h.hook)(req, res))
+          return true;
+      }
+
+      if (r.view_handler)
+      {
+        r.view_handler(req, res);
+        return true;
+      }
+
+      Request owned;
+      owned.method = req.method;
+      owned.path = std::string(req.path);
+      owned.params = extract_params_(r, parts);
+      owned.route = &r.options;
+      owned.body = req.body;
+      if (req.headers != nullptr)
+        owned.headers = *req.headers;
+      handler_for_(r, owned.params, &owned.headers)(owned, res);
+      return true;
+    }
+
+    /**
+     * @brief True if the route only matches requests with specific headers.
+     * @pre route_id < size()
+     */
+    bool has_header_predicates(std::size_t route_id) const { return !routes_[route_id].options.headers.empty(); }
+
+    /**
+     * @brief True if request headers can decide whether a path resolves to
+     *        this route: it has header predicates, or an earlier route that
+     *        can match the same paths does (requests it rejects fall through).
+     *
+     * Uses the prepare_hints() overlap lists when present.
+     * @pre route_id < size()
+     */
+    bool header_dependent(std::size_t route_id) const
+    {
+      const Route &b = routes_[route_id];
+      if (!b.options.headers.empty())
+        return true;
+      if (b.removed || variant_keys_.empty())
+        return false;
+
+      const auto predicated = [&](std::size_t a)
+      { return !routes_[a].removed && !routes_[a].options.headers.empty(); };
+
+      if (route_id < hinted_)
+        return std::any_of(b.shadows.begin(), b.shadows.end(), predicated);
+
+      for (const std::size_t a : by_depth_[b.segments.size()])
+      {
+        if (a >= route_id)
+          break;
+        if (predicated(a) && overlaps_(routes_[a], b))
+          return true;
+      }
+      return false;
+    }
+
+    /**
+     * @brief Match `req` without running anything: the id-only match().
+     *
+     * Fills req.params and req.route and returns the route id, copying no
+     * handler; queues and worker pools hand (id, req) to invoke() later.
+     * Header predicates are evaluated against req.headers.
+     * @return The matched route id, or npos (also for Limits rejections).
+     */
+    std::size_t route(Request &req) const
+    {
+      std::vector<std::string_view> parts;
+      int status = 0;
+
+      const std::size_t id = lookup_(req.method, req.path, &req.headers, parts, status);
+      if (id == npos)
+        return npos;
+
+      req.params = extract_params_(routes_[id], parts);
+      req.route = &routes_[id].options;
+      limit_body_(routes_[id], req.body);
+      return id;
+    }
+
+    /**
+     * @brief Calls the handler of a previously matched route.
+     *
+     * Lets a server match on one thread and run the handler on another by
+     * queueing only `route_id` + the request. `req.params` is expected to be
+     * already populated (e.g. from `Match::params`).
+     *
+     * @return false if `route_id` is out of range.
+     */
+    bool invoke(std::size_t route_id, const Request &req, Response &res) const
+    {
+      if (route_id >= routes_.size() || routes_[route_id].removed)
+        return false;
+
+      if (run_hooks_(routes_[route_id], req, res))
+        handler_for_(routes_[route_id], req.params, &req.headers)(req, res);
+      return true;
+    }
+
+    /**
+     * @brief Id of the route registered with exactly (method, pattern).
+     *
+     * Patterns compare by segments, so "/users/:id", "/users/{id}" and
+     * "/users/:id/" name the same route.
+     * @return The first live route id, or npos.
+     */
+    std::size_t find_route(Method method, std::string_view pattern) const
+    {
+      const auto segs = detail::parse_pattern(pattern);
+
+      for (std::size_t id = 0; id < routes_.size(); ++id)
+      {
+        const auto &r = routes_[id];
+        if (!r.removed && r.method == method && detail::same_segments(r.segments, segs))
+          return id;
+      }
+      return npos;
+    }
+
+    /**
+     * @brief Remove a route. Other route ids stay valid.
+     *
+     * The slot is kept (and skipped by matching) so ids held by queues,
+     * frozen tables or caches never point at a different route. Cost: the
+     * route's depth bucket (and its header-variant group, if any); the
+     * rest of the index is untouched.
+     *
+     * This edits the Router in place and is not safe while other threads
+     * match against it. For live updates, edit a copy and publish it
+     * (ReplicatedRouter::publish); that copy is O(total routes), as
+     * Routers share no structure.
+     * @return false if the id is unknown or already removed.
+     */
+    bool remove(std::size_t route_id)
+    {
+      if (route_id >= routes_.size() || routes_[route_id].removed)
+        return false;
+
+      Route &r = routes_[route_id];
+      auto &bucket = by_depth_[r.segments.size()];
+      bucket.erase(std::find(bucket.begin(), bucket.end(), route_id));
+
+      if (!variant_keys_.empty())
+      {
+        const std::string key = variant_key_(r);
+        if (variant_keys_.count(key) != 0)
+        {
+          std::vector<std::size_t> members;
+          for (const std::size_t id : bucket)
+          {
+            if (same_shape_(routes_[id], r))
+              members.push_back(id);
+          }
+          set_variants_(key, std::move(members));
+        }
+        r.variants.reset();
+      }
+
+      r.removed = true;
+      r.segments.clear();
+      r.segments.shrink_to_fit();
+      r.handler = nullptr;
+      r.view_handler = nullptr;
+      r.batch_handler = nullptr;
+      r.hooks.clear();
+      r.split.reset();
+      --live_;
+
+      while (!by_depth_.empty() && by_depth_.back().empty())
+        by_depth_.pop_back();
+      sync_segment_limit_();
+      return true;
+    }
+
+    bool remove(Method method, std::string_view pattern) { return remove(find_route(method, pattern)); }
+
+    /**
+     * @brief Swap the handler of a live route in place (id and precedence unchanged).
+     *
+     * O(1), but like remove() not safe while other threads match.
+     * @return false if the id is unknown or removed.
+     */
+    bool replace(std::size_t route_id, Handler handler)
+    {
+      if (route_id >= routes_.size() || routes_[route_id].removed)
+        return false;
+
+      routes_[route_id].handler = std::move(handler);
+      routes_[route_id].view_handler = nullptr;
+      routes_[route_id].batch_handler = nullptr;
+      routes_[route_id].split.reset();
+      return true;
+    }
+
+    bool replace(Method method, std::string_view pattern, Handler handler)
+    {
+      return replace(find_route(method, pattern), std::move(handler));
+    }
+
+    /**
+     * @brief Add a route whose requests are spread over weighted handlers.
+     *
+     * E.g. 95/5 canary: `split(Method::Get, "/checkout", {{95, a}, {5, b}})`.
+     * The variant is chosen after the path matched, from a per-thread RNG
+     * or, with a sticky key, from a hash of that param / header value.
+     *
+     * @throws std::invalid_argument if `variants` is empty, a handler is
+     *         empty or every weight is zero.
+     */
+    Router &split(Method method, std::string_view pattern, std::vector<Variant> variants,
+                  SplitOptions split_opts = {}, RouteOptions opts = {})
+    {
+      if (variants.empty())
+        throw std::invalid_argument("micro_router: split '" + std::string(pattern) + "' has no variants");
+      if (std::any_of(variants.begin(), variants.end(), [](const Variant &v)
+                      { return !v.handler; }))
+        throw std::invalid_argument("micro_router: split '" + std::string(pattern) + "' has an empty handler");
+      if (std::all_of(variants.begin(), variants.end(), [](const Variant &v)
+                      { return v.weight == 0; }))
+        throw std::invalid_argument("micro_router: split '" + std::string(pattern) + "' has only zero weights");
+
+      auto sp = std::make_shared<detail::Split>();
+      sp->weights = std::make_unique<std::atomic<std::uint32_t>[]>(variants.size());
+      sp->handlers.reserve(variants.size());
+      for (std::size_t i = 0; i < variants.size(); ++i)
+      {
+        sp->weights[i].store(variants[i].weight, std::memory_order_relaxed);
+        sp->handlers.push_back(std::move(variants[i].handler));
+      }
+      detail::to_lower(split_opts.sticky_header);
+      sp->options = std::move(split_opts);
+
+      add(method, pattern, nullptr, std::move(opts));
+      routes_.back().split = std::move(sp);
+      return *this;
+    }
+
+    /**
+     * @brief Retune the weights of a split route while it serves traffic.
+     *
+     * Each weight is stored atomically; a concurrent dispatch sees either
+     * the old or the new value of each variant. Copies of the Router
+     * (e.g. ReplicatedRouter replicas) share the weights. While a
+     * retune is half applied every weight may read zero for a moment;
+     * such a dispatch goes to the first variant.
+     * @return false if the route is not a split route, the count differs
+     *         or every weight is zero.
+     */
+    bool set_weights(std::size_t route_id, const std::vector<std::uint32_t> &weights) const
+    {
+      if (route_id >= routes_.size() || !routes_[route_id].split)
+        return false;
+
+      const detail::Split &sp = *routes_[route_id].split;
+      if (weights.size() != sp.handlers.size() ||
+          std::all_of(weights.begin(), weights.end(), [](std::uint32_t w)
+                      { return w == 0; }))
+        return false;
+
+      for (std::size_t i = 0; i < weights.size(); ++i)
+        sp.weights[i].store(weights[i], std::memory_order_relaxed);
+      return true;
+    }
+
+    /**
+     * @brief True if `route_id` was issued and has been removed since.
+     */
+    bool removed(std::size_t route_id) const { return route_id < routes_.size() && routes_[route_id].removed; }
+
+    /**
+     * @brief Options a route was registered with.
+     * @pre route_id < size()
+     */
+    const RouteOptions &route_options(std::size_t route_id) const { return routes_[route_id].options; }
+
+    /**
+     * @brief Method and pattern a route was registered with.
+     * @pre route_id < size()
+     */
+    Method route_method(std::size_t route_id) const { return routes_[route_id].method; }
+    const std::string &route_pattern(std::size_t route_id) const { return routes_[route_id].pattern; }
+
+    /**
+     * @brief Number of route ids issued so far (removed routes included).
+     *
+     * Valid ids are [0, size()); use `live()` for the number of routes that
+     * can still match.
+     */
+    std::size_t size() const noexcept { return routes_.size(); }
+
+    /**
+     * @brief Number of routes not removed.
+     */
+    std::size_t live() const noexcept { return live_; }
+
+    /**
+     * @brief Parsed segments of a route (empty once removed).
+     *
+     * For matchers built on top of the router, so they need not re-parse
+     * patterns.
+     */
+    const std::vector<detail::Segment> &route_segments(std::size_t id) const { return routes_[id].segments; }
+
+  private:
+    struct PrefixHook
+    {
+      std::vector<detail::Segment> segments;
+      std::shared_ptr<const Hook> hook;
+    };
+
+    /// A prefix hook as it covers one route.
+    struct RouteHook
+    {
+      std::shared_ptr<const Hook> hook;
+      std::vector<std::pair<std::string, std::string>> guards; // route param -> value the prefix requires
+    };
+
+    struct Route
+    {
+      Method method = Method::Any;
+      std::string pattern;
+      std::vector<detail::Segment> segments;
+      Handler handler;
+      ViewHandler view_handler; // add_view routes; `handler` adapts to it
+      BatchHandler batch_handler; // add_batch routes; `handler` adapts to it
+      std::vector<RouteHook> hooks; // prefix hooks that may cover this route, outermost first
+      std::shared_ptr<detail::Split> split; // weighted variants, replaces handler
+      RouteOptions options; // header names lowercased at registration
+      std::vector<std::size_t> shadows; // earlier routes overlapping this one (prepare_hints)
+      std::shared_ptr<const detail::VariantTable> variants; // set while header variants share this path
+      bool removed = false;
+    };
+
+    std::optional<Match> match_(Method method, std::string_view path, const Headers *headers) const
+    {
+      std::vector<std::string_view> parts;
+      int status = 0;
+
+      return make_match_(lookup_(method, path, headers, parts, status), parts, headers);
+    }
+
+    std::optional<Match> make_match_(std::size_t id, const std::vector<std::string_view> &parts, const Headers *headers) const
+    {
+      if (id == npos)
+        return std::nullopt;
+
+      Match m;
+      m.params = extract_params_(routes_[id], parts);
+      m.handler = handler_for_(routes_[id], m.params, headers);
+      m.route_id = id;
+      m.options = &routes_[id].options;
+      for (const RouteHook &h : routes_[id].hooks)
+      {
+        if (covers_(h, m.params))
+          m.hooks.push_back(h.hook);
+      }
+      return m;
+    }
+
+    /// Recompute the hooks covering `r` from prefix_hooks_.
+    void collect_hooks_(Route &r) const
+    {
+      r.hooks.clear();
+      if (prefix_hooks_.empty())
+        return;
+
+      std::vector<const PrefixHook *> covering;
+      for (const PrefixHook &ph : prefix_hooks_)
+      {
+        if (ph.segments.size() > r.segments.size())
+          continue;
+
+        bool under = true;
+        for (std::size_t i = 0; i < ph.segments.size() && under; ++i)
+        {
+          const auto &p = ph.segments[i];
+          const auto &s = r.segments[i];
+          if (p.kind == detail::Segment::Kind::Static && s.kind == detail::Segment::Kind::Static)
+            under = s.text == p.text;
+        }
+        if (under)
+          covering.push_back(&ph);
+      }
+
+      std::stable_sort(covering.begin(), covering.end(), [](const PrefixHook *a, const PrefixHook *b)
+                       { return a->segments.size() < b->segments.size(); });
+      for (const PrefixHook *ph : covering)
+      {
+        RouteHook h;
+        h.hook = ph->hook;
+        for (std::size_t i = 0; i < ph->segments.size(); ++i)
+        {
+          // A route param where the prefix has text: decided per request.
+          if (ph->segments[i].kind == detail::Segment::Kind::Static && r.segments[i].kind == detail::Segment::Kind::Param)
+            h.guards.emplace_back(r.segments[i].text, ph->segments[i].text);
+        }
+        r.hooks.push_back(std::move(h));
+      }
+    }
+
+    /// Does `h` apply to a request with these params (Params or ParamViews)?
+    template <class P>
+    static bool covers_(const RouteHook &h, const P &params)
+    {
+      for (const auto &[name, value] : h.guards)
+      {
+        if (!param_is_(params, name, value))
+          return false;
+      }
+      return true;
+    }
+
+    /// Compares the decoded value, as handlers read it ("%61dmin" is "admin").
+    static bool param_is_(const Params &params, const std::string &name, std::string_view text)
+    {
+      const auto it = params.find(name);
+      if (it == params.end())
+        return text.empty();
+      if (it->second.find('%') == std::string::npos)
+        return it->second == text;
+      return detail::percent_decode(it->second) == text;
+    }
+
+    static bool param_is_(const ParamViews &params, const std::string &name, std::string_view text)
+    {
+      return params.decoded(name) == text;
+    }
+
+    /// Runs r's hooks on a view of `req`; false if one stopped the request.
+    static bool run_hooks_(const Route &r, const Request &req, Response &res)
+    {
+      if (r.hooks.empty())
+        return true;
+
+      RequestView v;
+      v.method = req.method;
+      v.path = req.path;
+      v.query = detail::query_of(v.path);
+      v.headers = &req.headers;
+      v.route = req.route;
+      v.body = req.body;
+      for (const auto &seg : r.segments)
+      {
+        if (seg.kind != detail::Segment::Kind::Param)
+          continue;
+        const auto it = req.params.find(seg.text);
+        v.params.push_back({seg.text, it != req.params.end() ? std::string_view(it->second) : std::string_view{}});
+      }
+
+      for (const auto &h : r.hooks)
+      {
+        if (covers_(h, req.params) && !(*h.hook)(v, res))
+          return false;
+      }
+      return true;
+    }
+
+    static void limit_body_(const Route &r, BodySource *body)
+    {
+      if (body != nullptr && r.options.max_body_bytes != 0)
+        body->set_limit(r.options.max_body_bytes);
+    }
+
+    /// Tokenize under the limits, then find. On npos, `status` is the
+    /// rejection status (414 / 400), or 0 for a plain miss.
+    std::size_t lookup_(Method method, std::string_view path, const Headers *headers,
+                        std::vector<std::string_view> &parts, int &status, const RouteHint *hint = nullptr) const
+    {
+      if (limits_.max_path_bytes != 0 && std::min(path.find('?'), path.size()) > limits_.max_path_bytes)
+      {
+        status = 414;
+        return npos;
+      }
+      if (!detail::split_segments(path, parts, limits_.max_segments))
+      {
+        status = 414;
+        return npos;
+      }
+      return check_(method, parts, headers, status, hint);
+    }
+
+    /// lookup_ for a path split across fragments (see detail::split_segments).
+    std::size_t lookup_(Method method, const std::string_view *fragments, std::size_t count, const Headers *headers,
+                        std::vector<std::string_view> &parts, std::string &scratch, int &status) const
+    {
+      std::size_t bytes = 0; // path bytes, up to the first '?'
+      for (std::size_t f = 0; f < count; ++f)
+      {
+        const std::size_t q = fragments[f].find('?');
+        bytes += std::min(q, fragments[f].size());
+        if (q != std::string_view::npos)
+          break;
+      }
+
+      if (limits_.max_path_bytes != 0 && bytes > limits_.max_path_bytes)
+      {
+        status = 414;
+        return npos;
+      }
+      if (!detail::split_segments(fragments, count, parts, scratch, limits_.max_segments))
+      {
+        status = 414;
+        return npos;
+      }
+      return check_(method, parts, headers, status);
+    }
+
+    /// find_ plus the param length limit.
+    std::size_t check_(Method method, const std::vector<std::string_view> &parts, const Headers *headers, int &status,
+                       const RouteHint *hint = nullptr) const
+    {
+      const std::size_t id = hint != nullptr ? find_hinted_(method, parts, headers, hint->route_id)
+                                             : find_(method, parts, headers);
+      if (id == npos || limits_.max_param_bytes == 0)
+        return id;
+
+      const Route &r = routes_[id];
+      for (std::size_t i = 0; i < r.segments.size(); ++i)
+      {
+        if (r.segments[i].kind == detail::Segment::Kind::Param && parts[i].size() > limits_.max_param_bytes)
+        {
+          status = 400;
+          return npos;
+        }
+      }
+      return id;
+    }
+
+    /// Returns the index of the first route matching (method, parts), or npos.
+    /// Only static segments are compared; params are extracted for the winner.
+    /// Routes with header predicates need `headers` (nullptr never matches them).
+    std::size_t find_(Method method, const std::vector<std::string_view> &parts, const Headers *headers) const
+    {
+      if (parts.size() >= by_depth_.size())
+        return npos;
+
+      std::size_t best = npos;
+      for (const std::size_t id : by_depth_[parts.size()])
+      {
+        if (id >= best)
+          break;
+
+        const Route &r = routes_[id];
+        if (r.variants)
+        {
+          // The lowest member stands for the whole group.
+          if (id == r.variants->members.front() && fits_path_(r, method, parts))
+            best = std::min(best, pick_variant_(*r.variants, headers));
+          continue;
+        }
+        if (fits_(r, method, parts, headers))
+          return id;
+      }
+
+      return best;
+    }
+
+    /// find_, trying the hinted route first. The hint wins only if none of
+    /// its shadows (earlier overlapping routes) matches, so precedence holds.
+    std::size_t find_hinted_(Method method, const std::vector<std::string_view> &parts, const Headers *headers,
+                             std::size_t hint) const
+    {
+      if (hint < hinted_ && !routes_[hint].removed)
+      {
+        const Route &r = routes_[hint];
+        if (r.segments.size() == parts.size() && fits_(r, method, parts, headers))
+        {
+          bool shadowed = false;
+          for (const std::size_t s : r.shadows)
+          {
+            if (!routes_[s].removed && fits_(routes_[s], method, parts, headers))
+            {
+              shadowed = true;
+              break;
+            }
+          }
+          if (!shadowed)
+            return hint;
+        }
+      }
+      return find_(method, parts, headers);
+    }
+
+    /// True if `r` matches; `parts` must have r's segment count.
+    static bool fits_(const Route &r, Method method, const std::vector<std::string_view> &parts, const Headers *headers)
+    {
+      return fits_path_(r, method, parts) && headers_match_(r, headers);
+    }
+
+    static bool fits_path_(const Route &r, Method method, const std::vector<std::string_view> &parts)
+    {
+      if (!detail::method_matches(r.method, method))
+        return false;
+
+      for (std::size_t i = 0; i < r.segments.size(); ++i)
+      {
+        const auto &seg = r.segments[i];
+        if (seg.kind == detail::Segment::Kind::Static && parts[i] != seg.text)
+          return false;
+      }
+      return true;
+    }
+
+    /// Lowest member of `t` whose predicates hold, or npos.
+    std::size_t pick_variant_(const detail::VariantTable &t, const Headers *headers) const
+    {
+      if (!t.keyed)
+      {
+        for (const std::size_t id : t.members)
+        {
+          if (headers_match_(routes_[id], headers))
+            return id;
+        }
+        return npos;
+      }
+
+      std::size_t best = t.fallback;
+      if (headers != nullptr)
+      {
+        const auto h = headers->find(t.header);
+        if (h != headers->end())
+        {
+          const auto v = t.by_value.find(h->second);
+          if (v != t.by_value.end())
+            best = std::min(best, v->second);
+        }
+      }
+      return best;
+    }
+
+    /// Could some request match both `a` and `b`? (Same depth assumed.)
+    static bool overlaps_(const Route &a, const Route &b)
+    {
+      if (a.method != Method::Any && b.method != Method::Any && a.method != b.method)
+        return false;
+
+      for (std::size_t i = 0; i < a.segments.size(); ++i)
+      {
+        const auto &x = a.segments[i];
+        const auto &y = b.segments[i];
+        if (x.kind == detail::Segment::Kind::Static && y.kind == detail::Segment::Kind::Static && x.text != y.text)
+          return false;
+      }
+      return true;
+    }
+
+    /// Handler to run for a matched route; picks the variant of split routes.
+    static const Handler &handler_for_(const Route &r, const Params &params, const Headers *headers)
+    {
+      if (!r.split)
+        return r.handler;
+      return r.split->handlers[r.split->pick(params, headers)];
+    }
+
+    static bool headers_match_(const Route &r, const Headers *headers)
+    {
+      if (r.options.headers.empty())
+        return true;
+      if (headers == nullptr)
+        return false;
+
+      for (const auto &[name, value] : r.options.headers)
+      {
+        const auto it = headers->find(name);
+        if (it == headers->end() || it->second != value)
+          return false;
+      }
+      return true;
+    }
+
+    static Route make_route_(Method method, std::string pattern, Handler handler, RouteOptions opts)
+    {
+      Route r;
+      r.method = method;
+      r.segments = detail::parse_pattern(pattern);
+      r.pattern = std::move(pattern);
+      r.handler = std::move(handler);
+      r.options = std::move(opts);
+
+      for (auto &check : r.options.headers)
+        detail::to_lower(check.first);
+      return r;
+    }
+
+    /// Deepest live route, once limit_segments_to_routes() opted in.
+    void sync_segment_limit_()
+    {
+      if (segments_from_routes_)
+        limits_.max_segments = std::max<std::size_t>(1, by_depth_.empty() ? 1 : by_depth_.size() - 1);
+    }
+
+    /// Append a new route id to its depth bucket (ids stay ascending).
+    void index_(std::size_t id)
+    {
+      const std::size_t depth = routes_[id].segments.size();
+      if (by_depth_.size() <= depth)
+        by_depth_.resize(depth + 1);
+      by_depth_[depth].push_back(id);
+      sync_segment_limit_();
+
+      if (!routes_[id].options.headers.empty() || !variant_keys_.empty())
+      {
+        std::string key = variant_key_(routes_[id]);
+        if (!routes_[id].options.headers.empty() || variant_keys_.count(key) != 0)
+          group_variants_(key, id);
+      }
+    }
+
+    /// Method + path shape; routes with equal keys differ only by headers.
+    static std::string variant_key_(const Route &r)
+    {
+      std::string key(method_name(r.method));
+      for (const auto &seg : r.segments)
+      {
+        key += '/';
+        if (seg.kind == detail::Segment::Kind::Param)
+          key += '\0';
+        else
+          key += seg.text;
+      }
+      return key;
+    }
+
+    static bool same_shape_(const Route &a, const Route &b)
+    {
+      if (a.method != b.method || a.segments.size() != b.segments.size())
+        return false;
+      for (std::size_t i = 0; i < a.segments.size(); ++i)
+      {
+        if (a.segments[i].kind != b.segments[i].kind ||
+            (a.segments[i].kind == detail::Segment::Kind::Static && a.segments[i].text != b.segments[i].text))
+          return false;
+      }
+      return true;
+    }
+
+    /// (Re)build the variant table of the group `key` that route `rep` belongs to.
+    void group_variants_(const std::string &key, std::size_t rep)
+    {
+      std::vector<std::size_t> members;
+      for (const std::size_t id : by_depth_[routes_[rep].segments.size()])
+      {
+        if (same_shape_(routes_[id], routes_[rep]))
+          members.push_back(id);
+      }
+      set_variants_(key, std::move(members));
+    }
+
+    void set_variants_(const std::string &key, std::vector<std::size_t> members)
+    {
+      auto t = std::make_shared<detail::VariantTable>();
+      bool conditional = false;
+      t->keyed = true;
+      for (const std::size_t id : members)
+      {
+        const auto &h = routes_[id].options.headers;
+        if (h.empty())
+        {
+          t->fallback = std::min(t->fallback, id);
+          continue;
+        }
+        conditional = true;
+        if (h.size() != 1 || (!t->header.empty() && t->header != h.front().first))
+          t->keyed = false;
+        else
+          t->header = h.front().first;
+      }
+
+      if (t->keyed)
+      {
+        for (const std::size_t id : members)
+        {
+          const auto &h = routes_[id].options.headers;
+          if (!h.empty())
+            t->by_value.emplace(h.front().second, id); // ids ascend: keeps the lowest
+        }
+      }
+      t->members = members;
+
+      std::shared_ptr<const detail::VariantTable> shared;
+      if (conditional && members.size() > 1)
+        shared = std::move(t);
+      for (const std::size_t id : members)
+        routes_[id].variants = shared;
+
+      if (conditional)
+        variant_keys_.insert(key);
+      else
+        variant_keys_.erase(key);
+    }
+
+    /// Rebuild every depth bucket with exact sizes.
+    void reindex_()
+    {
+      std::vector<std::size_t> counts;
+      for (const auto &r : routes_)
+      {
+        if (r.removed)
+          continue;
+        if (counts.size() <= r.segments.size())
+          counts.resize(r.segments.size() + 1, 0);
+        ++counts[r.segments.size()];
+      }
+
+      by_depth_.assign(counts.size(), {});
+      for (std::size_t d = 0; d < counts.size(); ++d)
+        by_depth_[d].reserve(counts[d]);
+
+      for (std::size_t id = 0; id < routes_.size(); ++id)
+      {
+        if (!routes_[id].removed)
+          by_depth_[routes_[id].segments.size()].push_back(id);
+      }
+
+      // One pass per bucket that holds header predicates.
+      variant_keys_.clear();
+      for (const auto &bucket : by_depth_)
+      {
+        if (std::none_of(bucket.begin(), bucket.end(), [&](std::size_t id)
+                         { return !routes_[id].options.headers.empty(); }))
+          continue;
+
+        std::unordered_map<std::string, std::vector<std::size_t>> groups;
+        for (const std::size_t id : bucket)
+          groups[variant_key_(routes_[id])].push_back(id);
+        for (auto &[key, members] : groups)
+          set_variants_(key, std::move(members));
+      }
+      sync_segment_limit_();
+    }
+
+    static void fill_param_views_(const Route &r, const std::vector<std::string_view> &parts, ParamViews &out)
+    {
+      out.clear();
+      for (std::size_t i = 0; i < r.segments.size(); ++i)
+      {
+        if (r.segments[i].kind == detail::Segment::Kind::Param)
+          out.push_back({r.segments[i].text, parts[i]});
+      }
+    }
+
+    static Params extract_params_(const Route &r, const std::vector<std::string_view> &parts)
+    {
+      Params params;
+      for (std::size_t i = 0; i < r.segments.size(); ++i)
+      {
+        const auto &seg = r.segments[i];
+        if (seg.kind == detail::Segment::Kind::Param)
+          params.emplace(seg.text, std::string(parts[i]));
+      }
+      return params;
+    }
 
     std::vector<Route> routes_;
+    std::vector<std::vector<std::size_t>> by_depth_; // segment count -> live route ids, ascending
+    std::size_t live_ = 0;
+    Limits limits_{};
+    bool segments_from_routes_ = false; // max_segments follows by_depth_
+    std::size_t hinted_ = 0; // routes below this id have `shadows` computed
+    std::vector<PrefixHook> prefix_hooks_; // registration order
+    std::unordered_set<std::string> variant_keys_; // groups holding header predicates
   };
 
 } // namespace micro_router
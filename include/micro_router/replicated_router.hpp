@@ -0,0 +1,244 @@
+#pragma once
+
+/**
+ * @file replicated_router.hpp
+ * @brief Per-thread Router replicas allocated on the using thread (header-only).
+ *
+ * A single Router shared by every worker keeps its route vector and pattern
+ * strings on whichever NUMA node built it. ReplicatedRouter keeps one master
+ * copy and lazily gives each thread its own replica, copied *by that thread*
+ * on first use. With the default first-touch policy (Linux, Windows) the
+ * replica's memory is then local to the node the thread runs on.
+ *
+ * Notes:
+ * - Pin workers to cores/nodes, otherwise "local" is only a hint.
+ * - publish() swaps in a new master; each thread re-copies on its next
+ *   local() call; each update costs full copies (see publish()). The
+ *   read path is one thread-local compare plus one atomic load when
+ *   nothing changed; the per-thread map is only searched when a thread
+ *   switches between ReplicatedRouter instances.
+ * - A reference returned by local() stays valid until the same thread calls
+ *   local() again after a publish().
+ * - Replicas are owned by the instance: they are freed when their thread
+ *   exits, when a publish() is picked up, or when the instance is
+ *   destroyed, whichever comes first.
+ */
+
+#include <micro_router/micro_router.hpp>
+
+#include <atomic>
+#include <cstdint>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace micro_router
+{
+  /**
+   * @brief A frozen Router replicated lazily per thread.
+   *
+   * Typical usage:
+   * @code
+   * micro_router::ReplicatedRouter shared(std::move(router));
+   *
+   * // in each worker thread:
+   * shared.dispatch(req, res); // matches against this thread's replica
+   * @endcode
+   */
+  class ReplicatedRouter final
+  {
+  public:
+    explicit ReplicatedRouter(Router master)
+        : id_(next_id_()), master_(std::make_shared<const Router>(std::move(master)))
+    {
+      Registry &reg = registry_();
+      std::lock_guard<std::mutex> lock(reg.mutex);
+      reg.live[id_] = this;
+    }
+
+    ReplicatedRouter(const ReplicatedRouter &) = delete;
+    ReplicatedRouter &operator=(const ReplicatedRouter &) = delete;
+
+    ~ReplicatedRouter()
+    {
+      // After this, exiting threads no longer call back into us; their
+      // stale slots are swept on their next new slot. replicas_ frees the copies.
+      Registry &reg = registry_();
+      std::lock_guard<std::mutex> lock(reg.mutex);
+      reg.live.erase(id_);
+    }
+
+    /**
+     * @brief Replace the master; threads pick it up on their next local().
+     *
+     * The swap itself is O(1), but a live update is not O(depth): the
+     * caller builds `next` as a full Router (typically a copy of the old
+     * master plus remove() / replace()), and every thread then re-copies
+     * it in full. Both copies are O(total routes); Routers share no
+     * structure between versions.
+     */
+    void publish(Router next)
+    {
+      auto fresh = std::make_shared<const Router>(std::move(next));
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        master_ = std::move(fresh);
+      }
+      generation_.fetch_add(1, std::memory_order_release);
+    }
+
+    /**
+     * @brief The calling thread's replica (created on first use).
+     */
+    const Router &local() const
+    {
+      ThreadSlots &ts = thread_slots_();
+      Slot *slot = ts.last_id == id_ ? ts.last : &find_slot_(ts);
+      const std::uint64_t gen = generation_.load(std::memory_order_acquire);
+
+      if (slot->router == nullptr || slot->generation != gen)
+        refresh_(*slot, gen);
+
+      return *slot->router;
+    }
+
+    std::optional<Match> match(Method method, std::string_view path) const { return local().match(method, path); }
+    bool dispatch(Request &req, Response &res) const { return local().dispatch(req, res); }
+    bool dispatch(RequestView &req, Response &res) const { return local().dispatch(req, res); }
+
+    /**
+     * @brief Number of publish() calls so far.
+     */
+    std::uint64_t generation() const noexcept { return generation_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Replicas currently alive (one per thread that used this).
+     */
+    std::size_t replicas() const
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      return replicas_.size();
+    }
+
+  private:
+    struct Slot
+    {
+      std::uint64_t generation = 0;
+      Router *router = nullptr; // owned by the instance's replicas_
+    };
+
+    struct Registry
+    {
+      std::mutex mutex;
+      std::unordered_map<std::uint64_t, const ReplicatedRouter *> live;
+    };
+
+    // Keyed by instance id (never reused), so a destroyed ReplicatedRouter
+    // cannot hand its stale replica to a new one at the same address.
+    struct ThreadSlots
+    {
+      std::unordered_map<std::uint64_t, Slot> slots;
+      std::uint64_t last_id = 0; // ids start at 1
+      Slot *last = nullptr;
+
+      ~ThreadSlots()
+      {
+        Registry &reg = registry_();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (const auto &[id, slot] : slots)
+        {
+          const auto it = reg.live.find(id);
+          if (it != reg.live.end() && slot.router != nullptr)
+            it->second->release_(slot.router);
+        }
+      }
+    };
+
+    static Registry &registry_()
+    {
+      static Registry reg;
+      return reg;
+    }
+
+    static ThreadSlots &thread_slots_()
+    {
+      thread_local ThreadSlots slots;
+      return slots;
+    }
+
+    static std::uint64_t next_id_()
+    {
+      static std::atomic<std::uint64_t> next{1};
+      return next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// Slow path: this thread switched instances, or never used this one.
+    Slot &find_slot_(ThreadSlots &ts) const
+    {
+      auto it = ts.slots.find(id_);
+      if (it == ts.slots.end())
+      {
+        // New slot: first drop the slots of destroyed instances.
+        {
+          Registry &reg = registry_();
+          std::lock_guard<std::mutex> lock(reg.mutex);
+          for (auto s = ts.slots.begin(); s != ts.slots.end();)
+            s = reg.live.count(s->first) == 0 ? ts.slots.erase(s) : std::next(s);
+        }
+        it = ts.slots.emplace(id_, Slot{}).first;
+      }
+
+      ts.last_id = id_;
+      ts.last = &it->second; // node-based map: stable until erased
+      return it->second;
+    }
+
+    void refresh_(Slot &slot, std::uint64_t gen) const
+    {
+      std::shared_ptr<const Router> master;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        master = master_;
+      }
+      // Copy on this thread so the replica's allocations are first-touched here.
+      auto fresh = std::make_unique<Router>(*master);
+      Router *const old = slot.router;
+      slot.router = fresh.get();
+      slot.generation = gen;
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (old != nullptr)
+      {
+        for (auto &r : replicas_)
+        {
+          if (r.get() == old)
+          {
+            r = std::move(fresh);
+            return;
+          }
+        }
+      }
+      replicas_.push_back(std::move(fresh));
+    }
+
+    /// A thread holding `replica` exited.
+    void release_(Router *replica) const
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      replicas_.erase(std::remove_if(replicas_.begin(), replicas_.end(), [&](const std::unique_ptr<Router> &r)
+                                     { return r.get() == replica; }),
+                      replicas_.end());
+    }
+
+    const std::uint64_t id_;
+    mutable std::mutex mutex_;
+    std::shared_ptr<const Router> master_;
+    mutable std::vector<std::unique_ptr<Router>> replicas_; // guarded by mutex_
+    std::atomic<std::uint64_t> generation_{0};
+  };
+
+} // namespace micro_router
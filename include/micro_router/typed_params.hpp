@@ -0,0 +1,174 @@
+#pragma once
+
+/**
+ * @file typed_params.hpp
+ * @brief Bind route params straight into a user struct (header-only).
+ *
+ * Instead of pulling and converting `req.params.at("userId")` in every
+ * handler, declare the struct and which param feeds which member:
+ *
+ * @code
+ * struct UserPost { std::uint64_t userId; std::string_view slug; };
+ *
+ * micro_router::add_bound<UserPost>(router, Method::Get, "/users/:userId/posts/:slug",
+ *     [](const RequestView &req, const UserPost &p, Response &res) { ... },
+ *     micro_router::field("userId", &UserPost::userId),
+ *     micro_router::field("slug", &UserPost::slug));
+ * @endcode
+ *
+ * - Field names are checked against the pattern once, at registration
+ *   (std::invalid_argument if a field has no matching param).
+ * - Each field is resolved to its param position up front; a request parses
+ *   values directly from the path views, with no map and no lookup by name.
+ * - A value that does not convert (e.g. "abc" for an integer) answers 400
+ *   and the handler is not called.
+ *
+ * Supported member types: integers, bool ("true"/"false"/"1"/"0"),
+ * std::string_view (borrowed, valid during the call) and std::string.
+ * Specialize ParamParser<T> for your own types.
+ */
+
+#include <micro_router/micro_router.hpp>
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace micro_router
+{
+  /**
+   * @brief Converts one raw param value into T; specialize for custom types.
+   */
+  template <class T, class = void>
+  struct ParamParser;
+
+  template <class T>
+  struct ParamParser<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>>
+  {
+    static bool parse(std::string_view in, T &out)
+    {
+      const char *end = in.data() + in.size();
+      const auto [ptr, ec] = std::from_chars(in.data(), end, out);
+      return ec == std::errc() && ptr == end;
+    }
+  };
+
+  template <>
+  struct ParamParser<bool>
+  {
+    static bool parse(std::string_view in, bool &out)
+    {
+      if (in == "true" || in == "1")
+        out = true;
+      else if (in == "false" || in == "0")
+        out = false;
+      else
+        return false;
+      return true;
+    }
+  };
+
+  template <>
+  struct ParamParser<std::string_view>
+  {
+    static bool parse(std::string_view in, std::string_view &out)
+    {
+      out = in;
+      return true;
+    }
+  };
+
+  template <>
+  struct ParamParser<std::string>
+  {
+    static bool parse(std::string_view in, std::string &out)
+    {
+      out.assign(in.data(), in.size());
+      return true;
+    }
+  };
+
+  /**
+   * @brief "param name -> struct member" mapping, see `field()`.
+   */
+  template <class P, class T>
+  struct ParamField
+  {
+    std::string_view name;
+    T P::*member;
+  };
+
+  template <class P, class T>
+  ParamField<P, T> field(std::string_view name, T P::*member)
+  {
+    return ParamField<P, T>{name, member};
+  }
+
+  /**
+   * @brief Register a route whose handler receives its params as a `P`.
+   *
+   * `handler` is called as handler(const RequestView &, const P &, Response &).
+   * `P` must be default-constructible.
+   */
+  template <class P, class F, class... Fields>
+  Router &add_bound(Router &router, Method method, std::string_view pattern, F handler, Fields... fields)
+  {
+    static_assert(std::is_default_constructible_v<P>, "bound param struct must be default-constructible");
+
+    std::vector<std::string> names;
+    for (const auto &seg : detail::parse_pattern(pattern))
+    {
+      if (seg.kind == detail::Segment::Kind::Param)
+        names.push_back(seg.text);
+    }
+
+    // Position of each field's param among the pattern's params.
+    std::array<std::size_t, sizeof...(Fields)> slots{};
+    std::size_t i = 0;
+    auto locate = [&](std::string_view name)
+    {
+      for (std::size_t k = 0; k < names.size(); ++k)
+      {
+        if (names[k] == name)
+        {
+          slots[i++] = k;
+          return;
+        }
+      }
+      throw std::invalid_argument("micro_router: pattern '" + std::string(pattern) + "' has no param '" +
+                                  std::string(name) + "'");
+    };
+    (locate(fields.name), ...);
+
+    auto bound = [handler = std::move(handler), slots, fields = std::make_tuple(fields...)](const RequestView &req, Response &res)
+    {
+      P p{};
+      bool ok = true;
+      std::size_t k = 0;
+
+      std::apply([&](const auto &...f)
+                 { ((ok = ok && ParamParser<std::remove_reference_t<decltype(p.*(f.member))>>::parse(req.params[slots[k++]].second, p.*(f.member))), ...); },
+                 fields);
+
+      if (!ok)
+      {
+        res.status = 400;
+        return;
+      }
+      handler(req, static_cast<const P &>(p), res);
+    };
+
+    return router.add_view(method, pattern, std::move(bound));
+  }
+
+} // namespace micro_router
@@ -0,0 +1,328 @@
+#pragma once
+
+/**
+ * @file work_stealing.hpp
+ * @brief Work-stealing worker pool running matched routes (header-only).
+ *
+ * WorkStealingDispatcher matches on the submitting thread (Router::route,
+ * no handler copy) and runs handlers on a fixed set of workers through
+ * Router::invoke:
+ * - each worker owns a Chase-Lev deque: it pushes and pops at the bottom,
+ *   idle workers steal from the top of a random victim
+ * - placement is affinity-aware: a route's requests are handed to the same
+ *   worker (route id modulo workers), so its handler code and data stay in
+ *   that core's caches; stealing only moves work when that worker lags
+ * - submissions land in the chosen worker's inbox (a short mutex section),
+ *   since only the owner may push to a Chase-Lev deque
+ *
+ * @code
+ * micro_router::WorkStealingDispatcher pool(router, 8,
+ *     [](micro_router::Request &req, micro_router::Response &res) { send(req, res); });
+ *
+ * pool.submit(std::move(req)); // false: no route, answer 404 yourself
+ * @endcode
+ *
+ * Notes:
+ * - `done` runs on the worker after the handler, once per request.
+ * - The Router must outlive the pool and not change while it runs.
+ * - The destructor waits for every submitted request to finish.
+ */
+
+#include <micro_router/micro_router.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace micro_router
+{
+  namespace detail
+  {
+    /**
+     * @brief Bounded Chase-Lev deque of pointers (Lê et al., PPoPP'13).
+     *
+     * push/pop: owner thread only. steal: any thread.
+     */
+    template <class T>
+    class ChaseLevDeque
+    {
+    public:
+      explicit ChaseLevDeque(std::size_t capacity_pow2 = 1024)
+          : mask_(capacity_pow2 - 1), buf_(new std::atomic<T *>[capacity_pow2])
+      {
+      }
+
+      /// False when full (the caller keeps the item).
+      bool push(T *x)
+      {
+        const std::int64_t b = bottom_.load(std::memory_order_relaxed);
+        const std::int64_t t = top_.load(std::memory_order_acquire);
+        if (b - t > static_cast<std::int64_t>(mask_))
+          return false;
+
+        buf_[static_cast<std::size_t>(b) & mask_].store(x, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+        return true;
+      }
+
+      T *pop()
+      {
+        const std::int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top_.load(std::memory_order_relaxed);
+
+        if (t > b)
+        {
+          bottom_.store(b + 1, std::memory_order_relaxed);
+          return nullptr;
+        }
+
+        T *x = buf_[static_cast<std::size_t>(b) & mask_].load(std::memory_order_relaxed);
+        if (t == b)
+        {
+          // Last item: race thieves for it.
+          if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            x = nullptr;
+          bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+        return x;
+      }
+
+      T *steal()
+      {
+        std::int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b)
+          return nullptr;
+
+        T *x = buf_[static_cast<std::size_t>(t) & mask_].load(std::memory_order_relaxed);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+          return nullptr;
+        return x;
+      }
+
+      std::size_t free_slots() const
+      {
+        const std::int64_t used = bottom_.load(std::memory_order_relaxed) - top_.load(std::memory_order_acquire);
+        return mask_ + 1 - static_cast<std::size_t>(std::max<std::int64_t>(0, used));
+      }
+
+    private:
+      alignas(64) std::atomic<std::int64_t> top_{0};
+      alignas(64) std::atomic<std::int64_t> bottom_{0};
+      std::size_t mask_;
+      std::unique_ptr<std::atomic<T *>[]> buf_;
+    };
+  } // namespace detail
+
+  /**
+   * @brief Fixed pool of workers running matched requests, with stealing.
+   */
+  class WorkStealingDispatcher final
+  {
+  public:
+    using Done = std::function<void(Request &, Response &)>;
+
+    /// `workers` = 0 uses the hardware concurrency.
+    explicit WorkStealingDispatcher(const Router &router, std::size_t workers = 0, Done done = {})
+        : router_(&router), done_(std::move(done))
+    {
+      if (workers == 0)
+        workers = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+
+      workers_.reserve(workers);
+      for (std::size_t i = 0; i < workers; ++i)
+        workers_.push_back(std::make_unique<Worker>());
+
+      threads_.reserve(workers);
+      for (std::size_t i = 0; i < workers; ++i)
+        threads_.emplace_back([this, i]
+                              { run_(i); });
+    }
+
+    WorkStealingDispatcher(const WorkStealingDispatcher &) = delete;
+    WorkStealingDispatcher &operator=(const WorkStealingDispatcher &) = delete;
+
+    ~WorkStealingDispatcher()
+    {
+      wait_idle();
+      {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stop_ = true;
+      }
+      sleep_cv_.notify_all();
+      for (auto &t : threads_)
+        t.join();
+    }
+
+    /**
+     * @brief Match `req` here and queue it on its route's worker.
+     * @return false if no route matches (nothing is queued).
+     */
+    bool submit(Request req)
+    {
+      auto task = std::make_unique<Task>();
+      task->req = std::move(req);
+      task->route_id = router_->route(task->req);
+      if (task->route_id == Router::npos)
+        return false;
+
+      in_flight_.fetch_add(1, std::memory_order_relaxed);
+
+      Worker &w = *workers_[task->route_id % workers_.size()];
+      {
+        std::lock_guard<std::mutex> lock(w.inbox_mutex);
+        w.inbox.push_back(task.release());
+      }
+      {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        ++queued_;
+      }
+      sleep_cv_.notify_one();
+      return true;
+    }
+
+    /**
+     * @brief Block until every submitted request has finished.
+     */
+    void wait_idle()
+    {
+      std::unique_lock<std::mutex> lock(idle_mutex_);
+      idle_cv_.wait(lock, [this]
+                    { return in_flight_.load(std::memory_order_acquire) == 0; });
+    }
+
+    std::size_t workers() const noexcept { return workers_.size(); }
+
+    /// Tasks taken from another worker so far.
+    std::uint64_t steals() const noexcept { return steals_.load(std::memory_order_relaxed); }
+
+  private:
+    struct Task
+    {
+      Request req;
+      Response res;
+      std::size_t route_id = Router::npos;
+    };
+
+    struct Worker
+    {
+      detail::ChaseLevDeque<Task> deque;
+      std::mutex inbox_mutex;
+      std::deque<Task *> inbox;
+    };
+
+    /// Moves this worker's inbox into its deque (owner push only).
+    void drain_inbox_(Worker &w)
+    {
+      std::lock_guard<std::mutex> lock(w.inbox_mutex);
+      while (!w.inbox.empty() && w.deque.push(w.inbox.front()))
+        w.inbox.pop_front();
+    }
+
+    /// Takes one task from a victim: its deque first, then its inbox.
+    Task *steal_from_(Worker &v)
+    {
+      if (Task *t = v.deque.steal())
+        return t;
+
+      std::unique_lock<std::mutex> lock(v.inbox_mutex, std::try_to_lock);
+      if (!lock.owns_lock() || v.inbox.empty())
+        return nullptr;
+      Task *t = v.inbox.back(); // the newest: the owner keeps the FIFO head
+      v.inbox.pop_back();
+      return t;
+    }
+
+    Task *find_work_(std::size_t self, std::uint64_t &rng)
+    {
+      Worker &w = *workers_[self];
+      drain_inbox_(w);
+      if (Task *t = w.deque.pop())
+        return t;
+
+      const std::size_t n = workers_.size();
+      for (std::size_t attempt = 0; attempt < 2 * n && n > 1; ++attempt)
+      {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        const std::size_t victim = static_cast<std::size_t>(rng % n);
+        if (victim == self)
+          continue;
+        if (Task *t = steal_from_(*workers_[victim]))
+        {
+          steals_.fetch_add(1, std::memory_order_relaxed);
+          return t;
+        }
+      }
+      return nullptr;
+    }
+
+    void run_(std::size_t self)
+    {
+      std::uint64_t rng = 0x9E3779B97F4A7C15ull * (self + 1);
+
+      for (;;)
+      {
+        Task *t = find_work_(self, rng);
+        if (t == nullptr)
+        {
+          std::unique_lock<std::mutex> lock(sleep_mutex_);
+          if (stop_)
+            return;
+          if (queued_ == 0)
+            sleep_cv_.wait(lock, [this]
+                           { return stop_ || queued_ != 0; });
+          continue;
+        }
+
+        {
+          std::lock_guard<std::mutex> lock(sleep_mutex_);
+          --queued_;
+        }
+
+        std::unique_ptr<Task> task(t);
+        router_->invoke(task->route_id, task->req, task->res);
+        if (done_)
+          done_(task->req, task->res);
+        task.reset();
+
+        if (in_flight_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+          std::lock_guard<std::mutex> lock(idle_mutex_);
+          idle_cv_.notify_all();
+        }
+      }
+    }
+
+    const Router *router_;
+    Done done_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+    std::size_t queued_ = 0; // tasks in inboxes / deques, guarded by sleep_mutex_
+    bool stop_ = false;
+
+    std::mutex idle_mutex_;
+    std::condition_variable idle_cv_;
+    std::atomic<std::size_t> in_flight_{0};
+    std::atomic<std::uint64_t> steals_{0};
+  };
+
+} // namespace micro_router
@@ -1,8 +1,11 @@
 #include <micro_router/micro_router.hpp>
+#include <micro_router/typed_params.hpp>
 
 #include <cstdlib>
 #include <iostream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 
 static void expect(bool ok, const char *msg)
 {
@@ -88,6 +91,713 @@ int main()
     expect(!dispatched, "unknown route should not dispatch");
   }
 
+  // 6) match by route id, invoke later (deferred / cross-thread dispatch)
+  {
+    auto m = r.match(Method::Get, "/users/5");
+    expect(m.has_value(), "users/:id should match");
+    expect(m->route_id == 1, "users/:id should be route 1");
+
+    Request req{Method::Get, "/users/5", std::move(m->params)};
+    Response res;
+    expect(r.invoke(m->route_id, req, res), "invoke should call handler");
+    expect(res.body == "user=5", "invoke body should include id");
+    expect(!r.invoke(Router::npos, req, res), "invoke with npos should fail");
+  }
+
+  // 7) replace and remove keep other route ids stable
+  {
+    Router r2;
+    r2.get("/a", [](const Request &, Response &res)
+           { res.body = "a1"; });
+    r2.get("/users/:id", [](const Request &, Response &res)
+           { res.body = "u"; });
+    r2.get("/b", [](const Request &, Response &res)
+           { res.body = "b"; });
+
+    expect(r2.find_route(Method::Get, "/users/{id}/") == 1, "patterns compare by segments");
+    expect(r2.replace(Method::Get, "/a", [](const Request &, Response &res)
+                      { res.body = "a2"; }),
+           "replace by pattern should succeed");
+
+    Request ra{Method::Get, "/a"};
+    Response resa;
+    r2.dispatch(ra, resa);
+    expect(resa.body == "a2", "replaced handler should run");
+
+    expect(r2.remove(Method::Get, "/users/:id"), "remove by pattern should succeed");
+    expect(!r2.remove(1), "second remove should fail");
+    expect(r2.removed(1) && r2.live() == 2 && r2.size() == 3, "slot kept, live count updated");
+
+    Request ru{Method::Get, "/users/1"};
+    Response resu;
+    expect(!r2.dispatch(ru, resu), "removed route should not dispatch");
+    expect(!r2.invoke(1, ru, resu), "removed route should not be invoked");
+    expect(r2.match(Method::Get, "/b")->route_id == 2, "later ids unchanged");
+  }
+
+  // 8) bulk registration keeps ids and precedence of sequential add
+  {
+    std::vector<RouteSpec> specs;
+    for (int i = 0; i < 10000; ++i)
+      specs.push_back(RouteSpec{Method::Get, "/items/" + std::to_string(i), nullptr});
+    specs.push_back(RouteSpec{Method::Get, "/items/:id", [](const Request &req, Response &res)
+                              { res.body = "item=" + req.params.at("id"); }});
+
+    Router r3;
+    r3.get("/health", nullptr);
+    r3.add_all(std::move(specs), 4);
+
+    expect(r3.size() == 10002 && r3.live() == 10002, "all routes registered");
+    expect(r3.match(Method::Get, "/items/9999")->route_id == 10000, "static route keeps its id");
+
+    Request req{Method::Get, "/items/abc"};
+    Response res;
+    expect(r3.dispatch(req, res) && res.body == "item=abc", "param route after statics");
+  }
+
+  // 9) header predicates select a variant of the same path
+  {
+    Router r4;
+    RouteOptions v2;
+    v2.headers = {{"Accept-Version", "2"}};
+    r4.get("/orders", [](const Request &, Response &res)
+           { res.body = "v2"; },
+           v2);
+    r4.get("/orders", [](const Request &, Response &res)
+           { res.body = "v1"; });
+
+    Request req{Method::Get, "/orders"};
+    req.headers["accept-version"] = "2";
+    Response res;
+    expect(r4.dispatch(req, res) && res.body == "v2", "matching header picks v2");
+
+    req.headers["accept-version"] = "3";
+    expect(r4.dispatch(req, res) && res.body == "v1", "other value falls back to v1");
+
+    expect(r4.match(Method::Get, "/orders")->route_id == 1, "headerless match skips predicated routes");
+    expect(r4.match(Method::Get, "/orders", Headers{{"accept-version", "2"}})->route_id == 0, "match with headers");
+  }
+
+  // 10) weighted split with runtime weights and sticky keys
+  {
+    Router r5;
+    auto a = [](const Request &, Response &res)
+    { res.body = "a"; };
+    auto b = [](const Request &, Response &res)
+    { res.body = "b"; };
+
+    r5.split(Method::Get, "/checkout", {{100, a}, {0, b}});
+    r5.split(Method::Get, "/cart/:userId", {{50, a}, {50, b}}, SplitOptions{"userId", ""});
+
+    auto run = [&](const char *path)
+    {
+      Request req{Method::Get, path};
+      Response res;
+      r5.dispatch(req, res);
+      return res.body;
+    };
+
+    expect(run("/checkout") == "a", "100/0 goes to a");
+    expect(r5.set_weights(0, {0, 100}), "set_weights on split route");
+    expect(run("/checkout") == "b", "0/100 goes to b");
+    expect(!r5.set_weights(0, {1}), "weight count must match");
+    expect(!r5.set_weights(0, {0, 0}), "all-zero weights rejected");
+    expect(run("/checkout") == "b", "rejected weights leave the old ones");
+
+    auto rejects = [&](std::vector<Variant> variants)
+    {
+      try
+      {
+        r5.split(Method::Get, "/bad", std::move(variants));
+      }
+      catch (const std::invalid_argument &)
+      {
+        return true;
+      }
+      return false;
+    };
+    expect(rejects({}), "split without variants throws");
+    expect(rejects({{50, a}, {50, nullptr}}), "split with an empty handler throws");
+    expect(rejects({{0, a}, {0, b}}), "split with only zero weights throws");
+    expect(r5.size() == 2, "rejected splits add no route");
+
+    int hits_a = 0;
+    int hits_b = 0;
+    for (int i = 0; i < 200; ++i)
+    {
+      const std::string path = "/cart/" + std::to_string(i);
+      const std::string first = run(path.c_str());
+      expect(first == run(path.c_str()), "sticky param keeps its variant");
+      (first == "a" ? hits_a : hits_b)++;
+    }
+    expect(hits_a > 50 && hits_b > 50, "50/50 split spreads users");
+  }
+
+  // 11) method tokens: builtin, custom, unknown
+  {
+    expect(parse_method("GET") == Method::Get, "GET parses");
+    expect(parse_method("OPTIONS") == Method::Options, "OPTIONS parses");
+    expect(parse_method("CONNECT") == Method::Connect, "CONNECT parses");
+    expect(!parse_method("get").has_value(), "tokens are case-sensitive");
+    expect(!parse_method("PURGE").has_value(), "unregistered custom token");
+    expect(!parse_method(std::string_view("GET\0", 4)).has_value(), "trailing NUL is not GET");
+    expect(!parse_method(std::string_view("PUT\0\0\0\0", 7)).has_value(), "NUL padding is not PUT");
+
+    const auto purge = register_method("PURGE");
+    expect(purge.has_value() && static_cast<std::size_t>(*purge) >= 10, "custom id after builtins");
+    expect(register_method("PURGE") == purge, "registration is idempotent");
+    expect(parse_method("PURGE") == purge, "registered token parses");
+    expect(method_name(*purge) == "PURGE" && method_name(Method::Delete_) == "DELETE", "names round-trip");
+    expect(register_method("GET") == Method::Get, "builtin tokens are not re-registered");
+
+    Router r6;
+    r6.add(*purge, "/cache/:key", [](const Request &req, Response &res)
+           { res.body = "purged " + req.params.at("key"); });
+
+    Request req{*parse_method("PURGE"), "/cache/home"};
+    Response res;
+    expect(r6.dispatch(req, res) && res.body == "purged home", "custom method dispatches");
+    expect((method_bit(*purge) & method_bit(Method::Get)) == 0, "distinct mask bits");
+  }
+
+  // 12) borrowed requests: view handlers, plain handlers, Request fallback
+  {
+    Router r7;
+    r7.add_view(Method::Get, "/files/:dir/{name}", [](const RequestView &req, Response &res)
+                { res.body = std::string(req.params.get("dir")) + "|" + std::string(req.params.get("name")) + "|" + std::string(req.query); });
+    r7.get("/users/:id", [](const Request &req, Response &res)
+           { res.body = "user=" + req.params.at("id"); });
+
+    const char buffer[] = "/files/docs/readme.md?raw=1";
+    int state = 0;
+
+    RequestView v;
+    v.method = Method::Get;
+    v.path = buffer;
+    v.context = &state;
+    Response res;
+    expect(r7.dispatch(v, res), "view route should dispatch");
+    expect(res.body == "docs|readme.md|raw=1", "params and query are views into the buffer");
+    expect(v.params.find("dir")->data() == buffer + 7, "param value borrows the buffer");
+
+    // one view reused for the next requests on the connection
+    v.path = "/files/img/logo.png";
+    expect(r7.dispatch(v, res) && res.body == "img|logo.png|", "reused view: no stale query");
+    v.path = "/nope?x=1";
+    expect(!r7.dispatch(v, res) && v.params.size() == 0 && v.route == nullptr && v.query == "x=1",
+           "reused view: a miss leaves no stale params or route");
+
+    RequestView u;
+    u.method = Method::Get;
+    u.path = "/users/3";
+    expect(r7.dispatch(u, res) && res.body == "user=3", "plain handler via view dispatch");
+
+    Request req{Method::Get, "/files/a/b"};
+    expect(r7.dispatch(req, res) && res.body == "a|b|", "view route via Request dispatch");
+  }
+
+  // 13) resolve records views only; decoding is lazy and cached
+  {
+    Router r8;
+    r8.get("/auth/:token", nullptr);
+    r8.get("/files/:name", nullptr);
+
+    ParamViews pv;
+    const std::string path = "/files/my%20report%2Fq1.pdf";
+    expect(r8.resolve(Method::Get, path, pv) == 1, "resolve returns the route id");
+    expect(pv.get("name") == "my%20report%2Fq1.pdf", "raw value is a view");
+
+    const std::string_view d1 = pv.decoded("name");
+    expect(d1 == "my report/q1.pdf", "percent-decoded on demand");
+    expect(pv.decoded("name").data() == d1.data(), "decoded value is cached");
+
+    expect(r8.resolve(Method::Get, "/auth/abc", pv) == 0, "resolve reuses params storage");
+    expect(pv.decoded("token").data() == pv.get("token").data(), "no copy without escapes");
+    expect(pv.decoded("bad") == "" && r8.resolve(Method::Get, "/x/y/z", pv) == Router::npos, "misses");
+  }
+
+  // 14) params bound into a typed struct
+  {
+    struct UserPost
+    {
+      std::uint64_t userId = 0;
+      std::string_view slug;
+      bool draft = false;
+    };
+
+    Router r9;
+    add_bound<UserPost>(
+        r9, Method::Get, "/users/:userId/posts/{slug}/:draft",
+        [](const RequestView &, const UserPost &p, Response &res)
+        { res.body = std::to_string(p.userId) + ":" + std::string(p.slug) + ":" + (p.draft ? "d" : "p"); },
+        field("userId", &UserPost::userId), field("slug", &UserPost::slug), field("draft", &UserPost::draft));
+
+    RequestView v;
+    v.method = Method::Get;
+    v.path = "/users/42/posts/hello/true";
+    Response res;
+    expect(r9.dispatch(v, res) && res.body == "42:hello:d", "struct filled from path");
+
+    Request req{Method::Get, "/users/7/posts/x/0"};
+    Response res2;
+    expect(r9.dispatch(req, res2) && res2.body == "7:x:p", "binding works from Request too");
+
+    v.path = "/users/abc/posts/hello/true";
+    Response bad;
+    expect(r9.dispatch(v, bad) && bad.status == 400 && bad.body.empty(), "conversion failure answers 400");
+
+    bool threw = false;
+    try
+    {
+      add_bound<UserPost>(r9, Method::Get, "/users/:id", [](const RequestView &, const UserPost &, Response &) {},
+                          field("userId", &UserPost::userId));
+    }
+    catch (const std::invalid_argument &)
+    {
+      threw = true;
+    }
+    expect(threw, "unknown field name rejected at registration");
+  }
+
+  // 15) route metadata readable from match and dispatch
+  {
+    struct Policy
+    {
+      const char *scope;
+      std::size_t max_age;
+    };
+    static const Policy admin{"admin", 0};
+
+    RouteOptions opts;
+    opts.user_data = &admin;
+    opts.tag = 7;
+
+    Router r10;
+    r10.get("/admin/:page", [](const Request &req, Response &res)
+            { res.body = req.route->data<Policy>()->scope; },
+            opts);
+
+    auto m = r10.match(Method::Get, "/admin/users");
+    expect(m->options != nullptr && m->options->data<Policy>() == &admin, "metadata from match");
+    expect(m->options->tag == 7, "inline tag from match");
+
+    Request req{Method::Get, "/admin/users"};
+    Response res;
+    expect(r10.dispatch(req, res) && res.body == "admin", "metadata visible to handler");
+
+    RequestView v;
+    v.method = Method::Get;
+    v.path = "/admin/x";
+    expect(r10.dispatch(v, res) && v.route->tag == 7, "metadata on views");
+  }
+
+  // 16) early rejection limits
+  {
+    Router r11;
+    r11.get("/a/:id", [](const Request &, Response &res)
+            { res.status = 200; });
+    r11.get("/a/b/c", [](const Request &, Response &res)
+            { res.status = 200; });
+
+    r11.limit_segments_to_routes();
+    expect(r11.limits().max_segments == 3, "segment limit from deepest route");
+
+    Limits lim = r11.limits();
+    lim.max_path_bytes = 32;
+    lim.max_param_bytes = 4;
+    r11.set_limits(lim);
+
+    Request ok{Method::Get, "/a/1234"};
+    Response res;
+    expect(r11.dispatch(ok, res) && res.status == 200, "within limits");
+
+    Request deep{Method::Get, "/a/b/c/d/e"};
+    res = Response{};
+    expect(!r11.dispatch(deep, res) && res.status == 414, "too many segments -> 414");
+
+    Request longp{Method::Get, "/a/" + std::string(40, 'x')};
+    res = Response{};
+    expect(!r11.dispatch(longp, res) && res.status == 414, "path too long -> 414");
+
+    // the segment cap keeps following the live routes
+    r11.get("/a/b/c/d/e", [](const Request &, Response &res)
+            { res.status = 201; });
+    res = Response{};
+    expect(r11.dispatch(deep, res) && res.status == 201, "deeper route added later is reachable");
+    expect(r11.limits().max_segments == 5, "segment limit raised by add");
+    r11.remove(Method::Get, "/a/b/c/d/e");
+    expect(r11.limits().max_segments == 3, "segment limit lowered by remove");
+    r11.remove(Method::Get, "/a/b/c");
+    expect(r11.limits().max_segments == 2, "trailing empty depths are trimmed");
+
+    lim = r11.limits();
+    lim.max_segments = 8;
+    r11.set_limits(lim);
+    r11.get("/a/b/c/d/e/f/g/h/i", nullptr);
+    expect(r11.limits().max_segments == 8, "explicit limit is not re-derived");
+
+    Request bigp{Method::Get, "/a/12345"};
+    res = Response{};
+    expect(!r11.dispatch(bigp, res) && res.status == 400, "param too long -> 400");
+    expect(!r11.match(Method::Get, "/a/12345").has_value(), "match honours limits");
+
+    Request miss{Method::Get, "/zz"};
+    res = Response{};
+    expect(!r11.dispatch(miss, res) && res.status == 200, "plain miss leaves status");
+  }
+
+  // 17) route_head: per-route body limits before the body is read
+  {
+    RouteOptions small;
+    small.max_body_bytes = 64;
+
+    Router r12;
+    r12.post("/api/:what", [](const Request &, Response &res)
+             { res.body = "api"; },
+             small);
+    r12.post("/upload", [](const Request &, Response &res)
+             { res.body = "upload"; });
+
+    Request req{Method::Post, "/api/items"};
+    req.headers["content-length"] = "10";
+    Response res;
+    const std::size_t id = r12.route_head(req, res);
+    expect(id == 0 && req.params.at("what") == "items" && req.route->max_body_bytes == 64, "head routed");
+    expect(res.body.empty(), "route_head runs no handler");
+    expect(r12.invoke(id, req, res) && res.body == "api", "invoke after reading body");
+
+    req.headers["content-length"] = "65";
+    res = Response{};
+    expect(r12.route_head(req, res) == Router::npos && res.status == 413, "oversized body -> 413");
+
+    req.headers["content-length"] = "1x";
+    res = Response{};
+    expect(r12.route_head(req, res) == Router::npos && res.status == 400, "bad content-length -> 400");
+
+    Request up{Method::Post, "/upload"};
+    up.headers["content-length"] = "104857600";
+    res = Response{};
+    expect(r12.route_head(up, res) == 1, "unlimited route accepts large bodies");
+  }
+
+  // 18) streamed request body with flow control
+  {
+    const std::vector<std::string> chunks = {"hello ", "streamed ", "world"};
+    std::size_t next_chunk = 0;
+    std::size_t released = 0;
+
+    BodySource body(
+        [&]() -> std::string_view
+        { return next_chunk < chunks.size() ? std::string_view(chunks[next_chunk++]) : std::string_view{}; },
+        [&](std::size_t n)
+        { released += n; });
+
+    Router r13;
+    r13.post("/ingest", [](const Request &req, Response &res)
+             {
+               char buf[4];
+               for (std::size_t n = req.body->read(buf, sizeof buf); n != 0; n = req.body->read(buf, sizeof buf))
+                 res.body.append(buf, n);
+             });
+
+    Request req{Method::Post, "/ingest"};
+    req.body = &body;
+    Response res;
+    expect(r13.dispatch(req, res) && res.body == "hello streamed world", "body read in small pieces");
+    expect(body.done() && released == body.received(), "every chunk reported consumed");
+    expect(next_chunk == chunks.size(), "pulled only on demand");
+
+    RouteOptions small;
+    small.max_body_bytes = 8;
+    r13.post("/small", [](const Request &req, Response &res)
+             { res.body = req.body->read_all(); },
+             small);
+
+    next_chunk = 0;
+    BodySource limited([&]() -> std::string_view
+                       { return next_chunk < chunks.size() ? std::string_view(chunks[next_chunk++]) : std::string_view{}; });
+    Request up{Method::Post, "/small"};
+    up.body = &limited;
+    res = Response{};
+    expect(r13.dispatch(up, res) && limited.too_large() && res.body == "hello ", "route limit stops the body");
+
+    // a chunk copied out by read() is released before the next pull
+    next_chunk = 0;
+    released = 0;
+    BodySource eager([&]() -> std::string_view
+                     { return next_chunk < chunks.size() ? std::string_view(chunks[next_chunk++]) : std::string_view{}; },
+                     [&](std::size_t n)
+                     { released += n; });
+    char buf[6];
+    expect(eager.read(buf, sizeof buf) == 6 && released == 6, "emptied chunk reported at once");
+
+    // early exit: release() hands back the pending chunk, drain() skips the rest
+    expect(eager.read(buf, 3) == 3 && released == 6, "partial chunk still held");
+    eager.release();
+    expect(released == 6 + 9 && eager.done() && eager.read(buf, 3) == 0, "release ends the body");
+
+    next_chunk = 0;
+    released = 0;
+    BodySource skipped([&]() -> std::string_view
+                       { return next_chunk < chunks.size() ? std::string_view(chunks[next_chunk++]) : std::string_view{}; },
+                       [&](std::size_t n)
+                       { released += n; });
+    expect(skipped.read(buf, 2) == 2, "partial read");
+    expect(skipped.drain() == 18 && released == 20 && skipped.done(), "drain skips and reports the rest");
+  }
+
+  // 19) matching over non-contiguous buffers
+  {
+    auto noop = [](const Request &, Response &) {};
+    Router r14;
+    r14.get("/users/:id/posts/{slug}", noop);
+    r14.get("/a//b", noop);
+    r14.get("/", noop);
+
+    const std::string_view two[] = {"/users/4", "2/posts/hello?x=1"};
+    std::string scratch;
+    ParamViews pv;
+    expect(r14.resolve(Method::Get, two, 2, pv, scratch) == 0, "resolved across fragments");
+    expect(pv.get("id") == "42" && pv.get("slug") == "hello", "params across fragments");
+
+    const char *slug = pv.get("slug").data();
+    expect(slug >= two[1].data() && slug < two[1].data() + two[1].size(), "param inside a fragment is not copied");
+    expect(scratch == "42", "only the spanning param is copied");
+
+    // Every split point agrees with the contiguous match.
+    const char *paths[] = {"/users/42/posts/hello", "//a//b/", "/", "/users/42/x", "/users/42/posts/hello?q=/x"};
+    for (const char *p : paths)
+    {
+      const std::string_view whole(p);
+      const auto expected = r14.match(Method::Get, whole);
+      for (std::size_t cut = 0; cut <= whole.size(); ++cut)
+      {
+        const std::string_view frags[] = {whole.substr(0, cut), whole.substr(cut)};
+        const auto got = r14.match(Method::Get, frags, 2);
+        expect(got.has_value() == expected.has_value(), "fragment match agrees on hit/miss");
+        if (got)
+          expect(got->route_id == expected->route_id && got->params == expected->params, "fragment match agrees on params");
+      }
+    }
+  }
+
+  // 20) last-route hints keep match() precedence
+  {
+    auto noop = [](const Request &, Response &) {};
+    Router r15;
+    r15.get("/items/:id", noop);     // 0
+    r15.get("/items/latest", noop);  // 1, shadowed by 0
+    r15.get("/feed/:page", noop);    // 2
+    r15.post("/feed/:page", noop);   // 3
+    r15.get("/users/:id", noop);     // 4
+    r15.prepare_hints();
+    r15.get("/late/:x", noop);       // 5 (not prepared: full lookup)
+
+    RouteHint hint;
+    ParamViews pv;
+    expect(r15.resolve(Method::Get, "/feed/1", pv, hint) == 2 && hint.route_id == 2, "hint learned");
+    expect(r15.resolve(Method::Get, "/feed/2", pv, hint) == 2 && pv.get("page") == "2", "hint reused");
+    expect(r15.resolve(Method::Post, "/feed/3", pv, hint) == 3, "method mismatch falls back");
+
+    hint.route_id = 1; // stale / wrong hint: earlier route 0 must still win
+    expect(r15.resolve(Method::Get, "/items/latest", pv, hint) == 0, "shadowing route wins over hint");
+
+    hint.route_id = 5;
+    expect(r15.resolve(Method::Get, "/late/x", pv, hint) == 5, "unprepared route via full lookup");
+
+    const char *paths[] = {"/items/7", "/items/latest", "/feed/9", "/users/3", "/late/1", "/nope"};
+    for (const char *hp : paths)
+    {
+      for (std::size_t h = 0; h < 7; ++h)
+      {
+        RouteHint any{h};
+        const auto expected = r15.match(Method::Get, hp);
+        const auto got = r15.match(Method::Get, hp, any);
+        expect(got.has_value() == expected.has_value() && (!got || got->route_id == expected->route_id),
+               "any hint agrees with match()");
+      }
+    }
+  }
+
+  // 21) batch dispatch grouped by route
+  {
+    std::vector<std::string> trace;
+    std::size_t batch_calls = 0;
+
+    Router r16;
+    r16.get("/a/:n", [&](const Request &req, Response &res)
+            { trace.push_back("a" + req.params.at("n")); res.body = "a" + req.params.at("n"); });
+    r16.get("/b/:n", [&](const Request &req, Response &res)
+            { trace.push_back("b" + req.params.at("n")); res.body = "b" + req.params.at("n"); });
+    r16.add_batch(Method::Get, "/users/:id", [&](const std::vector<const Request *> &reqs, const std::vector<Response *> &res)
+                  {
+                    ++batch_calls;
+                    std::string ids; // one merged backend lookup
+                    for (const Request *q : reqs)
+                      ids += q->params.at("id");
+                    for (std::size_t i = 0; i < reqs.size(); ++i)
+                      res[i]->body = "user" + reqs[i]->params.at("id") + " of " + ids;
+                  });
+
+    std::vector<Request> batch = {
+        {Method::Get, "/b/1"}, {Method::Get, "/a/1"}, {Method::Get, "/users/7"}, {Method::Get, "/b/2"},
+        {Method::Get, "/nope"}, {Method::Get, "/a/2"}, {Method::Get, "/users/8"}};
+    std::vector<Response> out;
+
+    expect(r16.dispatch_batch(batch, out) == 6 && out.size() == 7, "batch matched");
+    expect((trace == std::vector<std::string>{"a1", "a2", "b1", "b2"}), "handlers grouped, arrival order kept");
+    expect(out[0].body == "b1" && out[1].body == "a1" && out[3].body == "b2" && out[5].body == "a2", "responses in request order");
+    expect(out[4].status == 404, "miss answered 404");
+    expect(batch_calls == 1 && out[2].body == "user7 of 78" && out[6].body == "user8 of 78", "batch handler got its group");
+
+    Request single{Method::Get, "/users/9"};
+    Response res;
+    expect(r16.dispatch(single, res) && res.body == "user9 of 9", "batch route via plain dispatch");
+
+    r16.replace(Method::Get, "/users/:id", [](const Request &req, Response &res)
+                { res.body = "single" + req.params.at("id"); });
+    std::vector<Request> again = {{Method::Get, "/users/1"}, {Method::Get, "/users/2"}};
+    expect(r16.dispatch_batch(again, out) == 2 && batch_calls == 2, "replaced route leaves batch mode");
+    expect(out[0].body == "single1" && out[1].body == "single2", "replacement handler runs per request");
+  }
+
+  // 22) prefix hooks
+  {
+    std::vector<std::string> trace;
+
+    Router r17;
+    r17.get("/admin/users/:id", [&](const Request &, Response &)
+            { trace.push_back("handler"); });
+    r17.hook("/admin", [&](const RequestView &req, Response &res)
+             {
+               trace.push_back("auth");
+               if (req.headers == nullptr || req.headers->count("authorization") == 0)
+               {
+                 res.status = 401;
+                 return false;
+               }
+               return true; });
+    r17.hook("/admin/users/:id", [&](const RequestView &req, Response &)
+             { trace.push_back("user " + std::string(req.params.get("id"))); return true; });
+    r17.hook("/", [&](const RequestView &, Response &)
+             { trace.push_back("root"); return true; });
+    r17.get("/api/v1/items", [&](const Request &, Response &)
+            { trace.push_back("items"); }); // added after the hooks
+    r17.get("/public", [&](const Request &, Response &) {});
+    r17.hook("/api/v1", [&](const RequestView &, Response &res)
+             { res.body = "deprecated"; return true; });
+
+    auto m = r17.match(Method::Get, "/admin/users/3");
+    expect(m->hooks.size() == 3, "hooks come with the match");
+    expect(r17.match(Method::Get, "/public")->hooks.size() == 1, "only the root hook covers /public");
+
+    Request denied{Method::Get, "/admin/users/3"};
+    Response res;
+    expect(r17.dispatch(denied, res) && res.status == 401, "hook stops the request");
+    expect((trace == std::vector<std::string>{"root", "auth"}), "outermost first, handler skipped");
+
+    trace.clear();
+    Request ok{Method::Get, "/admin/users/3"};
+    ok.headers["authorization"] = "token";
+    res = Response{};
+    expect(r17.dispatch(ok, res) && res.status == 200, "hooks pass");
+    expect((trace == std::vector<std::string>{"root", "auth", "user 3", "handler"}), "hooks then handler");
+
+    trace.clear();
+    Request items{Method::Get, "/api/v1/items"};
+    res = Response{};
+    expect(r17.dispatch(items, res) && res.body == "deprecated", "hook applied to earlier route");
+    expect((trace == std::vector<std::string>{"root", "items"}), "route added after hooks is covered");
+
+    trace.clear();
+    RequestView v;
+    v.method = Method::Get;
+    v.path = "/admin/users/4";
+    res = Response{};
+    expect(r17.dispatch(v, res) && res.status == 401, "hooks on the view path");
+
+    // a param segment can spell the prefix: the hook follows the value
+    r17.get("/:section/settings", [&](const Request &, Response &)
+            { trace.push_back("settings"); });
+
+    trace.clear();
+    Request sneaky{Method::Get, "/admin/settings"};
+    res = Response{};
+    expect(r17.dispatch(sneaky, res) && res.status == 401, "prefix hook covers a param route");
+    expect((trace == std::vector<std::string>{"root", "auth"}), "handler not reached");
+
+    trace.clear();
+    Request open{Method::Get, "/public/settings"};
+    res = Response{};
+    expect(r17.dispatch(open, res) && res.status == 200, "other values pass");
+    expect((trace == std::vector<std::string>{"root", "settings"}), "auth hook skipped for other values");
+
+    expect(r17.match(Method::Get, "/admin/settings")->hooks.size() == 2, "match lists the applying hook");
+    expect(r17.match(Method::Get, "/public/settings")->hooks.size() == 1, "and leaves it out otherwise");
+
+    v.path = "/admin/settings";
+    res = Response{};
+    expect(r17.dispatch(v, res) && res.status == 401, "view path checks the value too");
+
+    trace.clear();
+    Request encoded{Method::Get, "/%61dmin/settings"};
+    res = Response{};
+    expect(r17.dispatch(encoded, res) && res.status == 401, "percent-encoded prefix is still covered");
+    expect((trace == std::vector<std::string>{"root", "auth"}), "encoded spelling does not reach the handler");
+
+    v.path = "/%61dm%69n/settings";
+    res = Response{};
+    expect(r17.dispatch(v, res) && res.status == 401, "view path compares the decoded value");
+    expect(r17.match(Method::Get, "/%61dmin/settings")->hooks.size() == 2, "match decodes before checking");
+
+    const auto sm = r17.match(Method::Get, "/admin/settings");
+    Request queued{Method::Get, "/admin/settings"};
+    queued.params = sm->params;
+    res = Response{};
+    expect(r17.invoke(sm->route_id, queued, res) && res.status == 401, "invoke checks the value too");
+  }
+
+  // 23) header variants resolve through one table lookup, precedence kept
+  {
+    Router r18;
+    auto version = [](const char *v)
+    {
+      RouteOptions o;
+      o.headers = {{"Accept-Version", v}};
+      return o;
+    };
+    auto noop = [](const Request &, Response &) {};
+
+    r18.get("/docs/:id", noop, version("1"));    // 0
+    r18.get("/:any/special", noop, version("2")); // 1: different shape, same depth
+    r18.get("/docs/:id", noop, version("2"));    // 2
+    r18.get("/docs/:id", noop);                  // 3: fallback
+    r18.get("/docs/:id", noop, version("9"));    // 4: below the fallback, never wins
+
+    auto id = [&](const char *path, const char *v)
+    {
+      Headers h;
+      if (v != nullptr)
+        h["accept-version"] = v;
+      const auto m = r18.match(Method::Get, path, h);
+      return m ? m->route_id : Router::npos;
+    };
+
+    expect(id("/docs/a", "1") == 0, "first variant");
+    expect(id("/docs/a", "2") == 2, "second variant");
+    expect(id("/docs/a", "9") == 3, "fallback precedes a later variant");
+    expect(id("/docs/a", nullptr) == 3, "no header: fallback");
+    expect(id("/docs/special", "2") == 1, "earlier overlapping route still wins");
+
+    r18.remove(3);
+    expect(id("/docs/a", "9") == 4, "removed fallback uncovers the later variant");
+    expect(id("/docs/a", nullptr) == Router::npos, "no fallback left");
+
+    Router copy = r18;
+    copy.get("/docs/:id", noop, version("1")); // 5: shadowed by 0
+    expect(copy.match(Method::Get, "/docs/a", Headers{{"accept-version", "1"}})->route_id == 0, "lowest id per value");
+  }
+
   std::cout << "micro_router: all tests passed\n";
   return 0;
 }
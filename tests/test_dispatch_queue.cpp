@@ -0,0 +1,208 @@
+#include <micro_router/dispatch_queue.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static void expect(bool ok, const char *msg)
+{
+  if (!ok)
+  {
+    std::cerr << "Test failed: " << msg << "\n";
+    std::exit(1);
+  }
+}
+
+int main()
+{
+  using namespace micro_router;
+  using std::chrono::milliseconds;
+
+  Router r;
+
+  r.get("/batch/:id", [](const Request &req, Response &res)
+        { res.body = "batch=" + req.params.at("id"); });
+
+  r.get("/interactive", [](const Request &, Response &res)
+        { res.body = "interactive"; },
+        RouteOptions{5, milliseconds(10)});
+
+  using Clock = DispatchQueue::Clock;
+  const Clock::time_point t0 = Clock::now();
+
+  // 1) strict priority: queued interactive overtakes queued batch
+  {
+    DispatchQueue q(r);
+
+    expect(q.push(Request{Method::Get, "/batch/1"}, t0), "batch should queue");
+    expect(q.push(Request{Method::Get, "/batch/2"}, t0), "batch should queue");
+    expect(q.push(Request{Method::Get, "/interactive"}, t0), "interactive should queue");
+    expect(!q.push(Request{Method::Get, "/nope"}, t0), "unknown route should not queue");
+    expect(q.size() == 3, "three requests queued");
+
+    auto a = q.pop(t0);
+    expect(a.has_value() && a->req.path == "/interactive", "interactive first");
+
+    auto b = q.pop(t0);
+    expect(b.has_value() && b->req.path == "/batch/1", "batch FIFO inside class");
+
+    Response res;
+    expect(q.run(*b, res), "run should call handler");
+    expect(res.body == "batch=1", "params should be carried through the queue");
+  }
+
+  // 2) starvation protection: an old batch request beats fresh interactive
+  {
+    DispatchQueue::Config cfg;
+    cfg.starvation_limit = milliseconds(50);
+    DispatchQueue q(r, cfg);
+
+    q.push(Request{Method::Get, "/batch/old"}, t0);
+    q.push(Request{Method::Get, "/interactive"}, t0 + milliseconds(90));
+
+    auto a = q.pop(t0 + milliseconds(100));
+    expect(a.has_value() && a->req.path == "/batch/old", "starving batch should run first");
+  }
+
+  // 3) earliest deadline first
+  {
+    DispatchQueue::Config cfg;
+    cfg.policy = SchedulePolicy::EarliestDeadline;
+    cfg.default_deadline = milliseconds(500);
+    DispatchQueue q(r, cfg);
+
+    q.push(Request{Method::Get, "/batch/1"}, t0);                       // due t0+500ms
+    q.push(Request{Method::Get, "/interactive"}, t0 + milliseconds(5)); // due t0+15ms
+    q.push(Request{Method::Get, "/batch/2"}, t0);                       // due t0+500ms
+
+    expect(q.pop()->req.path == "/interactive", "EDF: interactive first");
+    expect(q.pop()->req.path == "/batch/1", "EDF: FIFO on equal deadlines");
+    expect(q.pop()->req.path == "/batch/2", "EDF: last batch");
+    expect(q.empty() && !q.pop().has_value(), "queue drained");
+  }
+
+  // 4) CoDel admission: shed only after delay stays above target for an interval
+  {
+    Router cr;
+    cr.get("/work", [](const Request &, Response &res)
+           { res.body = "done"; });
+    cr.get("/patient", [](const Request &, Response &res)
+           { res.body = "done"; },
+           RouteOptions{0, std::chrono::microseconds(0), std::chrono::seconds(10)});
+
+    DispatchQueue::Config cfg;
+    cfg.admission = Admission::CoDel;
+    cfg.codel_target = milliseconds(5);
+    cfg.codel_interval = milliseconds(100);
+    DispatchQueue q(cr, cfg);
+
+    for (int i = 0; i < 5; ++i)
+      q.push(Request{Method::Get, "/work"}, t0);
+    q.push(Request{Method::Get, "/patient"}, t0);
+    q.push(Request{Method::Get, "/work"}, t0 + milliseconds(299));
+
+    expect(!q.pop(t0 + milliseconds(1))->shed, "below target: admitted");
+    expect(!q.pop(t0 + milliseconds(10))->shed, "first above target: still admitted");
+    expect(!q.pop(t0 + milliseconds(50))->shed, "above target within interval: admitted");
+
+    auto dropped = q.pop(t0 + milliseconds(120));
+    expect(dropped->shed, "above target for a full interval: shed");
+
+    Response res;
+    expect(!q.run(*dropped, res), "shed request should not run");
+    expect(res.status == 503, "shed request should answer 503");
+
+    expect(!q.pop(t0 + milliseconds(121))->shed, "next drop is spaced by the control law");
+    expect(!q.pop(t0 + milliseconds(300))->shed, "per-route target override: admitted");
+    expect(!q.pop(t0 + milliseconds(300))->shed, "low delay leaves dropping state");
+  }
+
+  // 5) a lenient per-route target does not disable shedding for others
+  {
+    Router cr;
+    cr.get("/w", [](const Request &, Response &) {});
+    cr.get("/p", [](const Request &, Response &) {},
+           RouteOptions{0, std::chrono::microseconds(0), std::chrono::seconds(10)});
+
+    DispatchQueue::Config cfg;
+    cfg.admission = Admission::CoDel;
+    cfg.codel_target = milliseconds(5);
+    cfg.codel_interval = milliseconds(100);
+
+    auto shed_count = [&](bool mixed)
+    {
+      DispatchQueue q(cr, cfg);
+      for (int i = 0; i < 2000; ++i)
+        q.push(Request{Method::Get, (mixed && i % 2 == 1) ? "/p" : "/w"}, t0 + milliseconds(i));
+
+      std::size_t shed_w = 0;
+      for (int i = 0; i < 2000; ++i)
+      {
+        auto job = q.pop(t0 + milliseconds(50 + 2 * i)); // queue delay grows steadily
+        if (job->shed)
+        {
+          expect(job->req.path == "/w", "only the strict route is shed");
+          ++shed_w;
+        }
+      }
+      return shed_w;
+    };
+
+    expect(shed_count(false) > 0, "standing queue shed");
+    expect(shed_count(true) > 0, "still shed with a lenient route interleaved");
+  }
+
+  // 6) concurrent producers and consumers: every request popped exactly once
+  {
+    Router cr;
+    for (int p = 0; p < 4; ++p)
+      cr.get("/c" + std::to_string(p) + "/:n", [](const Request &, Response &) {},
+             RouteOptions{static_cast<std::uint8_t>(p * 60)});
+
+    for (const SchedulePolicy policy : {SchedulePolicy::StrictPriority, SchedulePolicy::EarliestDeadline})
+    {
+      DispatchQueue::Config cfg;
+      cfg.policy = policy;
+      DispatchQueue q(cr, cfg);
+
+      constexpr int producers = 4;
+      constexpr int per_producer = 2000;
+      std::vector<std::atomic<int>> seen(producers * per_producer);
+      std::atomic<int> popped{0};
+
+      std::vector<std::thread> threads;
+      for (int t = 0; t < producers; ++t)
+        threads.emplace_back([&, t]
+                             {
+                               for (int i = 0; i < per_producer; ++i)
+                                 q.push(Request{Method::Get, "/c" + std::to_string(i % 4) + "/" +
+                                                                 std::to_string(t * per_producer + i)}); });
+      for (int t = 0; t < 3; ++t)
+        threads.emplace_back([&]
+                             {
+                               while (popped.load() < producers * per_producer)
+                               {
+                                 if (auto job = q.pop())
+                                 {
+                                   seen[static_cast<std::size_t>(std::stoi(job->req.params.at("n")))].fetch_add(1);
+                                   popped.fetch_add(1);
+                                 }
+                               } });
+      for (auto &t : threads)
+        t.join();
+
+      bool once = true;
+      for (const auto &n : seen)
+        once = once && n.load() == 1;
+      expect(once, "each request popped exactly once");
+      expect(q.empty() && !q.pop().has_value(), "queue drained after concurrent use");
+    }
+  }
+
+  std::cout << "micro_router dispatch_queue: all tests passed\n";
+  return 0;
+}
@@ -0,0 +1,181 @@
+#include <micro_router/frozen_table.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static void expect(bool ok, const char *msg)
+{
+  if (!ok)
+  {
+    std::cerr << "Test failed: " << msg << "\n";
+    std::exit(1);
+  }
+}
+
+int main()
+{
+  using namespace micro_router;
+
+  // Parent process: routes are declared once, handlers are irrelevant here.
+  Router r;
+  r.get("/health", nullptr);
+  r.get("/users/:id", nullptr);
+  r.any("/posts/{postId}/comments/{id}", nullptr);
+
+  const std::vector<unsigned char> image = freeze(r);
+
+  // Worker: the image is mapped somewhere else (simulated by a copy).
+  const std::vector<unsigned char> mapped(image.begin(), image.end());
+  FrozenTable table(mapped.data(), mapped.size());
+
+  expect(table.valid(), "image should be recognized");
+  expect(table.size() == 3, "three routes in the image");
+
+  // 1) ids are the Router's ids
+  {
+    expect(table.find(Method::Get, "/health") == 0, "health is route 0");
+    expect(table.find(Method::Post, "/health") == Router::npos, "method should be checked");
+    expect(table.find(Method::Get, "/nope") == Router::npos, "unknown path should not match");
+
+    auto m = table.match(Method::Delete_, "/posts/7/comments/99/?x=1");
+    expect(m.has_value() && m->route_id == 2, "any-method braced route should match");
+    expect(m->params.at("postId") == "7" && m->params.at("id") == "99", "params should be extracted");
+  }
+
+  // 2) handlers bound per process by route id
+  {
+    std::vector<Handler> handlers(table.size());
+    handlers[1] = [](const Request &req, Response &res)
+    { res.body = "user=" + req.params.at("id"); };
+
+    Request req{Method::Get, "/users/42"};
+    Response res;
+    expect(table.dispatch(req, res, handlers), "bound route should dispatch");
+    expect(res.body == "user=42", "handler should see params");
+
+    Request unbound{Method::Get, "/health"};
+    expect(!table.dispatch(unbound, res, handlers), "unbound route should not dispatch");
+  }
+
+  // 3) removed routes keep their slot in the image
+  {
+    Router r2 = r;
+    r2.remove(0);
+    const std::vector<unsigned char> image2 = freeze(r2);
+    FrozenTable t2(image2.data(), image2.size());
+
+    expect(t2.size() == 3, "removed route keeps its id");
+    expect(t2.find(Method::Get, "/health") == Router::npos, "removed route should not match");
+    expect(t2.find(Method::Get, "/users/1") == 1, "other ids unchanged");
+  }
+
+  // 4) generated tenant routes: shared texts are stored once
+  {
+    Router big;
+    const char *tails[] = {"/orders", "/orders/:id", "/invoices/:id", "/users/:id/settings"};
+    for (int t = 0; t < 2000; ++t)
+    {
+      for (const char *tail : tails)
+        big.get("/tenants/t" + std::to_string(t) + tail, nullptr);
+    }
+    big.get("/:a/:b/:c", nullptr); // params only, lowest precedence
+
+    const std::vector<unsigned char> img = freeze(big);
+    FrozenTable bt(img.data(), img.size());
+
+    expect(bt.image_size() / big.size() < 32, "4-route tenant shape should stay under 32 bytes per route");
+    expect(bt.find(Method::Get, "/tenants/t1234/orders/9") == 1234 * 4 + 1, "tenant route should match by id");
+    expect(bt.find(Method::Get, "/tenants/t1999/users/5/settings") == 1999 * 4 + 3, "last tenant should match");
+    expect(bt.find(Method::Get, "/tenants/t77/unknown") == big.size() - 1, "params-only route should catch the rest");
+    expect(bt.find(Method::Get, "/tenants/t77/unknown/x/y") == Router::npos, "no route for deeper paths");
+  }
+
+  // 5) precedence across keys: first registered route wins
+  {
+    Router p;
+    p.get("/:tenant/orders", nullptr);
+    p.get("/t1/orders", nullptr);
+    p.get("/:a/:b", nullptr);
+
+    const std::vector<unsigned char> img = freeze(p);
+    FrozenTable pt(img.data(), img.size());
+
+    expect(pt.find(Method::Get, "/t1/orders") == 0, "earlier param route should win");
+    expect(pt.find(Method::Get, "/t1/other") == 2, "params-only route as fallback");
+  }
+
+  // 6) foreign bytes are rejected
+  {
+    std::vector<unsigned char> junk(64, 0xAB);
+    expect(!FrozenTable(junk.data(), junk.size()).valid(), "junk should be rejected");
+    expect(!FrozenTable(image.data(), 8).valid(), "truncated image should be rejected");
+  }
+
+  // 7) corrupt offsets and counts are rejected, never read out of bounds
+  {
+    auto patched = [&](std::size_t field_offset, std::uint32_t value)
+    {
+      std::vector<unsigned char> bad(image);
+      std::memcpy(bad.data() + field_offset, &value, sizeof value);
+      return FrozenTable(bad.data(), bad.size()).valid();
+    };
+    using H = detail::FrozenHeader;
+    const auto h = detail::load_pod<H>(image.data(), 0);
+
+    expect(FrozenTable(image.data(), image.size()).valid(), "intact image accepted");
+    expect(!patched(offsetof(H, route_count), 1000000), "route count past the image");
+    expect(!patched(offsetof(H, strings_offset), h.total_size + 4), "strings past the image");
+    expect(!patched(offsetof(H, ranges_offset), 0xFFFFFFF0u), "section offset overflow");
+    expect(!patched(offsetof(H, wild_count), h.range_count + 1), "wild ranges past Range[]");
+
+    // a route pointing past Segment[]
+    expect(!patched(h.routes_offset + offsetof(detail::FrozenRoute, first_segment), h.segment_count), "route segments out of range");
+    // a text pointing past the strings
+    expect(!patched(h.texts_offset + offsetof(detail::FrozenText, size), 0xFFFFu), "text out of range");
+    // a range naming a route that does not exist
+    expect(!patched(h.ranges_offset + offsetof(detail::FrozenRange, first_id), h.route_count), "range out of range");
+
+    // every truncation of a valid image is rejected
+    bool all_rejected = true;
+    for (std::size_t n = 0; n < image.size(); ++n)
+    {
+      std::vector<unsigned char> cut(image.begin(), image.begin() + static_cast<std::ptrdiff_t>(n));
+      all_rejected = all_rejected && !FrozenTable(cut.data(), cut.size()).valid();
+    }
+    expect(all_rejected, "truncated images rejected");
+  }
+
+  // 8) patterns too deep for the image are rejected at build time
+  {
+    Router deep;
+    std::string pattern;
+    for (int i = 0; i < 65536; ++i)
+      pattern += "/a";
+    deep.get(pattern, nullptr);
+
+    bool thrown = false;
+    try
+    {
+      freeze(deep);
+    }
+    catch (const std::length_error &)
+    {
+      thrown = true;
+    }
+    expect(thrown, "65536 segments do not fit the image");
+
+    Router max;
+    max.get(pattern.substr(2), nullptr); // 65535 segments
+    const std::vector<unsigned char> img = freeze(max);
+    expect(FrozenTable(img.data(), img.size()).valid(), "65535 segments still fit");
+  }
+
+  std::cout << "micro_router frozen_table: all tests passed\n";
+  return 0;
+}
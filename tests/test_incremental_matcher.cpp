@@ -0,0 +1,132 @@
+#include <micro_router/incremental_matcher.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+static void expect(bool ok, const char *msg)
+{
+  if (!ok)
+  {
+    std::cerr << "Test failed: " << msg << "\n";
+    std::exit(1);
+  }
+}
+
+int main()
+{
+  using namespace micro_router;
+  using Status = IncrementalMatcher::Status;
+
+  auto noop = [](const Request &, Response &) {};
+
+  Router router;
+  router.get("/users/:id", noop);               // 0
+  router.get("/users/:id/posts/{slug}", noop);  // 1
+  router.post("/items", noop);                  // 2
+  router.get("/a//b", noop);                    // 3
+  router.get("/", noop);                        // 4
+
+  // 1) path split across several buffers, params located by offset
+  {
+    const std::string stream = "/users/42/posts/hello-world?x=1";
+    IncrementalMatcher m(router, Method::Get);
+
+    expect(m.feed("/us") == Status::Pending, "prefix pending");
+    expect(m.feed("ers/4") == Status::Pending, "split param pending");
+    expect(m.feed("2/posts/hel") == Status::Pending, "still pending");
+    expect(m.feed("lo-world?x=1") == Status::Pending && m.ended(), "query ends the path");
+    expect(m.finish() == Status::Matched && m.route_id() == 1, "deeper route matched");
+
+    const auto id = m.param("id");
+    const auto slug = m.param("slug");
+    expect(id && stream.substr(id->offset, id->size) == "42", "param span across buffers");
+    expect(slug && stream.substr(slug->offset, slug->size) == "hello-world", "last param span");
+  }
+
+  // 2) early rejection
+  {
+    IncrementalMatcher m(router, Method::Get);
+    expect(m.feed("/use") == Status::Pending, "pending on a prefix");
+    expect(m.feed("rz") == Status::NoMatch, "no route can match: reported mid-segment");
+
+    m.reset(Method::Get);
+    expect(m.feed("/it") == Status::MethodNotAllowed, "only POST routes left");
+
+    m.reset(Method::Post);
+    m.feed("/items/");
+    expect(m.finish() == Status::Matched && m.route_id() == 2, "trailing slash tolerated");
+
+    m.reset(Method::Delete_);
+    m.feed("/users/7");
+    expect(m.finish() == Status::MethodNotAllowed, "405 at finish");
+  }
+
+  // 3) agrees with Router::match on slashes and the root
+  {
+    IncrementalMatcher m(router, Method::Get);
+    m.feed("//a/");
+    m.feed("/b");
+    expect(m.finish() == Status::Matched && m.route_id() == 3, "empty middle segment");
+
+    m.reset(Method::Get);
+    m.feed("/ HTTP/1.1");
+    expect(m.finish() == Status::Matched && m.route_id() == 4, "root path, rest of request line ignored");
+  }
+
+  // 4) router limits
+  {
+    Router limited = router;
+    limited.limit_segments_to_routes();
+
+    IncrementalMatcher m(limited, Method::Get);
+    expect(m.feed("/users/1/posts/2/x/y") == Status::TooLong, "too many segments");
+  }
+
+  // 5) candidates come from the first bytes; removed routes never qualify
+  {
+    Router r = router;
+    r.remove(2);
+
+    IncrementalMatcher m(r, Method::Post);
+    expect(m.status() == Status::Pending, "nothing decided before any byte");
+    expect(m.feed("/it") == Status::NoMatch, "removed route is not a candidate");
+
+    m.reset(Method::Get);
+    m.feed("/users/9");
+    expect(m.finish() == Status::Matched && m.route_id() == 0, "reset after an early verdict");
+    expect(m.finish() == Status::Matched, "finish is idempotent");
+  }
+
+  // 6) same verdict as Router::match under a byte limit, query included
+  {
+    Router limited = router;
+    Limits lim;
+    lim.max_path_bytes = 12;
+    limited.set_limits(lim);
+
+    const char *targets[] = {"/users/42", "/users/42?page=1&sort=desc&filter=long", "/users/123456789",
+                             "/users/1/posts/x", "/a//b?zzzzzzzzzzzzzzzz"};
+    for (const char *t : targets)
+    {
+      IncrementalMatcher m(limited, Method::Get);
+      const std::string_view target(t);
+      for (std::size_t i = 0; i < target.size(); i += 3) // arrives in small pieces
+        m.feed(target.substr(i, 3));
+      const Status got = m.finish();
+
+      const auto expected = limited.match(Method::Get, target);
+      expect((got == Status::Matched) == expected.has_value(), "matcher agrees with Router::match");
+      if (expected)
+        expect(m.route_id() == expected->route_id, "same route as Router::match");
+
+      Request req{Method::Get, std::string(target)};
+      Response res;
+      const bool dispatched = limited.dispatch(req, res);
+      expect(dispatched || (got == Status::TooLong) == (res.status == 414), "same 414 verdict as dispatch");
+    }
+  }
+
+  std::cout << "incremental_matcher: all tests passed\n";
+  return 0;
+}
@@ -0,0 +1,98 @@
+#include <micro_router/manifest.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+static void expect(bool ok, const char *msg)
+{
+  if (!ok)
+  {
+    std::cerr << "Test failed: " << msg << "\n";
+    std::exit(1);
+  }
+}
+
+int main()
+{
+  using namespace micro_router;
+
+  HandlerRegistry handlers;
+  handlers["health"] = [](const Request &, Response &res)
+  { res.body = "ok"; };
+  handlers["users.show"] = [](const Request &req, Response &res)
+  { res.body = "user=" + req.params.at("id"); };
+
+  // 1) routes, comments, options
+  {
+    const char *text =
+        "# routes\n"
+        "GET   /health      health\n"
+        "\n"
+        "GET\t/users/:id\tusers.show  priority=5 deadline_ms=20   # inline comment\r\n"
+        "ANY   /any/{x}     health   max_body_bytes=65536\n";
+
+    Router r;
+    const ManifestResult res = load_manifest(text, handlers, r);
+
+    expect(res.ok, "manifest should load");
+    expect(res.routes == 3 && r.size() == 3, "three routes registered");
+    expect(r.route_options(1).priority == 5, "priority option applied");
+    expect(r.route_options(1).deadline == std::chrono::milliseconds(20), "deadline option applied");
+    expect(r.route_method(2) == Method::Any, "ANY method parsed");
+    expect(r.route_options(2).max_body_bytes == 65536, "max_body_bytes option applied");
+
+    Request req{Method::Get, "/users/9"};
+    Response out;
+    expect(r.dispatch(req, out) && out.body == "user=9", "handler bound by name");
+  }
+
+  // 2) errors carry line numbers and leave the router untouched
+  {
+    Router r;
+    ManifestResult res = load_manifest("GET /health health\nFETCH /x health\n", handlers, r);
+    expect(!res.ok && res.line == 2, "unknown method reported on line 2");
+    expect(r.size() == 0, "router untouched on error");
+
+    res = load_manifest("\n\nGET /x nope\n", handlers, r);
+    expect(!res.ok && res.line == 3, "unknown handler reported on line 3");
+
+    res = load_manifest("GET /x health priority=900\n", handlers, r);
+    expect(!res.ok && res.line == 1, "out of range option reported");
+
+    res = load_manifest("GET /x health\nGET /y health deadline_ms=9999999999999999999\n", handlers, r);
+    expect(!res.ok && res.line == 2 && res.error.rfind("option value out of range", 0) == 0,
+           "huge deadline_ms rejected instead of overflowing");
+    res = load_manifest("GET /x health codel_target_ms=86400001\n", handlers, r);
+    expect(!res.ok && res.line == 1, "codel_target_ms above one day rejected");
+    res = load_manifest("GET /x health deadline_ms=86400000\n", handlers, r);
+    expect(res.ok, "one day deadline accepted");
+    r = Router{};
+
+    res = load_manifest("GET health\n", handlers, r);
+    expect(!res.ok, "missing pattern reported");
+  }
+
+  // 3) from a file
+  {
+    const std::string path = "micro_router_test_manifest.txt";
+    {
+      std::ofstream out(path);
+      out << "GET /health health\n";
+    }
+
+    Router r;
+    const ManifestResult res = load_manifest_file(path, handlers, r);
+    std::remove(path.c_str());
+
+    expect(res.ok && r.size() == 1, "file manifest should load");
+    expect(!load_manifest_file("does/not/exist", handlers, r).ok, "missing file reported");
+    const ManifestResult dir = load_manifest_file(".", handlers, r);
+    expect(!dir.ok && dir.line == 0, "directory reported, not thrown");
+  }
+
+  std::cout << "micro_router manifest: all tests passed\n";
+  return 0;
+}
@@ -0,0 +1,106 @@
+#include <micro_router/match_memo.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+static void expect(bool ok, const char *msg)
+{
+  if (!ok)
+  {
+    std::cerr << "Test failed: " << msg << "\n";
+    std::exit(1);
+  }
+}
+
+int main()
+{
+  using namespace micro_router;
+
+  auto noop = [](const Request &, Response &) {};
+
+  Router router;
+  router.get("/users/:id/posts/{slug}", noop);
+
+  RouteOptions v2;
+  v2.headers = {{"accept-version", "2"}};
+  router.get("/orders", noop, v2);
+  router.get("/orders", noop);
+
+  // 1) fingerprint-keyed: repeats skip matching, params point into the new bytes
+  {
+    MatchMemo memo(router);
+    ParamViews pv;
+
+    const std::string first = "/users/7/posts/hi";
+    expect(memo.resolve(Method::Get, first, pv) == 0 && memo.misses() == 1, "first lookup matches");
+
+    const std::string again = first; // same bytes, different buffer
+    expect(memo.resolve(Method::Get, again, pv) == 0 && memo.hits() == 1, "repeat is a hit");
+    expect(pv.get("id") == "7" && pv.get("slug") == "hi", "params rebuilt from offsets");
+    expect(pv.get("id").data() == again.data() + 7, "params view into the current path");
+
+    expect(memo.resolve(Method::Post, again, pv) == Router::npos, "method is part of the key");
+    expect(memo.resolve(Method::Get, "/users/8/posts/hi", pv) == 0 && pv.get("id") == "8", "different path misses");
+  }
+
+  // 2) table-entry keyed, with eviction
+  {
+    MatchMemo memo(router);
+    ParamViews pv;
+
+    expect(memo.resolve(42, Method::Get, "/users/1/posts/a", pv) == 0, "entry resolved");
+    expect(memo.resolve(42, Method::Get, "/users/1/posts/a", pv) == 0 && memo.hits() == 1, "entry hit");
+
+    memo.evict(42);
+    expect(memo.resolve(42, Method::Get, "/users/2/posts/b", pv) == 0 && pv.get("id") == "2", "evicted entry re-resolved");
+    expect(memo.hits() == 1, "eviction forced a miss");
+  }
+
+  // 3) header predicates and router changes are never served stale
+  {
+    MatchMemo memo(router);
+    ParamViews pv;
+    Headers h{{"accept-version", "2"}};
+
+    expect(memo.resolve(Method::Get, "/orders", pv, &h) == 1, "conditional route");
+    expect(memo.resolve(Method::Get, "/orders", pv) == 2, "conditional route not memoized");
+
+    Router copy = router;
+    MatchMemo memo2(copy);
+    expect(memo2.resolve(Method::Get, "/users/1/posts/a", pv) == 0, "cached");
+    copy.remove(0);
+    expect(memo2.resolve(Method::Get, "/users/1/posts/a", pv) == Router::npos, "removal clears the memo");
+  }
+
+  // 4) a fallback reached by skipping a predicated route is not memoized
+  {
+    MatchMemo memo(router);
+    ParamViews pv;
+    Headers h{{"accept-version", "2"}};
+
+    expect(memo.resolve(Method::Get, "/orders", pv) == 2, "plain request: fallback");
+    expect(memo.resolve(Method::Get, "/orders", pv, &h) == 1, "header request still gets its variant");
+    expect(memo.hits() == 0, "nothing header-dependent was served from the memo");
+
+    Router prepared = router;
+    prepared.prepare_hints();
+    expect(prepared.header_dependent(2) && !prepared.header_dependent(0), "overlap lists give the same answer");
+  }
+
+  // 5) changing the router's limits clears the memo
+  {
+    Router copy = router;
+    MatchMemo memo(copy);
+    ParamViews pv;
+
+    expect(memo.resolve(Method::Get, "/users/1/posts/a", pv) == 0, "cached");
+    Limits lim;
+    lim.max_segments = 2;
+    copy.set_limits(lim);
+    expect(memo.resolve(Method::Get, "/users/1/posts/a", pv) == Router::npos, "new limits apply to repeats");
+  }
+
+  std::cout << "match_memo: all tests passed\n";
+  return 0;
+}
@@ -0,0 +1,93 @@
+#include <micro_router/replicated_router.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+static void expect(bool ok, const char *msg)
+{
+  if (!ok)
+  {
+    std::cerr << "Test failed: " << msg << "\n";
+    std::exit(1);
+  }
+}
+
+int main()
+{
+  using namespace micro_router;
+
+  Router base;
+  base.get("/users/:id", [](const Request &req, Response &res)
+           { res.body = "v1 user=" + req.params.at("id"); });
+
+  ReplicatedRouter shared(std::move(base));
+
+  // 1) the calling thread gets a stable replica
+  const Router *main_replica = &shared.local();
+  expect(main_replica == &shared.local(), "replica should be reused on the same thread");
+
+  // 2) another thread gets its own replica that matches the same routes
+  {
+    const Router *other_replica = nullptr;
+    std::string body;
+
+    std::thread t([&]
+                  {
+      other_replica = &shared.local();
+      Request req{Method::Get, "/users/7"};
+      Response res;
+      shared.dispatch(req, res);
+      body = res.body; });
+    t.join();
+
+    expect(other_replica != main_replica, "each thread should have its own replica");
+    expect(body == "v1 user=7", "replica should dispatch like the master");
+  }
+
+  // 3) publish swaps the master; threads re-copy on next use
+  {
+    Router next;
+    next.get("/users/:id", [](const Request &req, Response &res)
+             { res.body = "v2 user=" + req.params.at("id"); });
+    shared.publish(std::move(next));
+
+    expect(shared.generation() == 1, "publish should bump generation");
+
+    Request req{Method::Get, "/users/8"};
+    Response res;
+    expect(shared.dispatch(req, res), "new master should dispatch");
+    expect(res.body == "v2 user=8", "new master should be used after publish");
+  }
+
+  // 4) replicas are released on thread exit and instance destruction
+  {
+    auto sentinel = std::make_shared<int>(0);
+    Router r;
+    r.get("/x", [sentinel](const Request &, Response &) {});
+    const long base_uses = sentinel.use_count();
+
+    {
+      ReplicatedRouter rr(r);
+      std::thread t([&]
+                    { rr.local(); });
+      t.join();
+      expect(rr.replicas() == 0, "exited thread's replica freed");
+
+      rr.local();
+      expect(rr.replicas() == 1, "this thread's replica alive");
+    }
+    // master + this thread's replica are gone with the instance
+    expect(sentinel.use_count() == base_uses, "destroyed instance leaves no replica behind");
+
+    // the next instance used by this thread sweeps the stale slot
+    ReplicatedRouter again(r);
+    again.local();
+    expect(again.replicas() == 1, "fresh instance gets its own replica");
+  }
+
+  std::cout << "micro_router replicated_router: all tests passed\n";
+  return 0;
+}
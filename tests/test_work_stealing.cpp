@@ -0,0 +1,87 @@
+#include <micro_router/work_stealing.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static void expect(bool ok, const char *msg)
+{
+  if (!ok)
+  {
+    std::cerr << "Test failed: " << msg << "\n";
+    std::exit(1);
+  }
+}
+
+int main()
+{
+  using namespace micro_router;
+
+  // 1) every request runs once, with its own params, on some worker
+  {
+    std::atomic<std::size_t> hot{0};
+    std::atomic<std::size_t> cold{0};
+    std::atomic<std::size_t> done{0};
+    std::atomic<std::size_t> bad{0};
+
+    Router router;
+    router.get("/hot/:n", [&](const Request &req, Response &res)
+               {
+                 ++hot;
+                 res.body = req.params.at("n"); });
+    router.get("/cold", [&](const Request &, Response &)
+               { ++cold; });
+
+    {
+      WorkStealingDispatcher pool(router, 4, [&](Request &req, Response &res)
+                                  {
+                                    if (req.path.rfind("/hot/", 0) == 0 && res.body != req.path.substr(5))
+                                      ++bad;
+                                    ++done; });
+      expect(pool.workers() == 4, "four workers");
+
+      for (std::size_t i = 0; i < 5000; ++i)
+      {
+        Request req;
+        req.method = Method::Get;
+        req.path = i % 10 == 0 ? "/cold" : "/hot/" + std::to_string(i);
+        expect(pool.submit(std::move(req)), "submit matched");
+      }
+
+      Request miss;
+      miss.method = Method::Get;
+      miss.path = "/nope";
+      expect(!pool.submit(std::move(miss)), "unmatched request not queued");
+
+      pool.wait_idle();
+      expect(done == 5000, "every request completed");
+    }
+
+    expect(hot == 4500 && cold == 500, "handlers ran exactly once");
+    expect(bad == 0, "responses paired with their requests");
+  }
+
+  // 2) the destructor drains outstanding work
+  {
+    std::atomic<std::size_t> ran{0};
+    Router router;
+    router.get("/x", [&](const Request &, Response &)
+               { ++ran; });
+    {
+      WorkStealingDispatcher pool(router, 2);
+      for (int i = 0; i < 1000; ++i)
+      {
+        Request req;
+        req.method = Method::Get;
+        req.path = "/x";
+        pool.submit(std::move(req));
+      }
+    }
+    expect(ran == 1000, "destructor waited for queued requests");
+  }
+
+  std::cout << "work_stealing: all tests passed\n";
+  return 0;
+}